@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace laxer {
+
+    // 自环状态的加速器
+    // 字符串内容, 空白和标识符的后半部分等状态在大多数字节上都转换到自身,
+    // 加速器把这些字节表示为少数几个区间, 用SIMD一次检查16个字节, 直接跳到第一个离开该状态的字节
+    class accelerator {
+       public:
+        inline static constexpr std::size_t max_ranges = 4;
+        inline static constexpr std::size_t alphabet_size =
+            std::numeric_limits<unsigned char>::max() + 1;
+
+       private:
+        // 16个相同字节, 可以直接作为SIMD向量读取
+        using lanes_t = std::array<std::uint8_t, 16>;
+
+        // 自环字节的区间[low, low + span], 未使用的区间重复第一个区间, 使检查不需要分支;
+        // 预先展开为向量, 短的自环不需要每次重新广播
+        alignas(16) std::array<lanes_t, max_ranges> lows;
+        alignas(16) std::array<lanes_t, max_ranges> spans;
+        // 区间数, 0表示没有加速器
+        std::uint8_t count;
+
+        inline bool contains(unsigned char ch) const noexcept
+        {
+            bool result = false;
+            for (std::size_t i = 0; i < max_ranges; i++) {
+                result |= static_cast<std::uint8_t>(ch - this->lows[i][0])
+                       <= this->spans[i][0];
+            }
+
+            return result;
+        }
+
+       public:
+        accelerator(void): lows {}, spans {}, count(0)
+        {
+        }
+
+        // 由状态转换到自身的字节集合生成, 集合为空或超过max_ranges个区间时没有加速器
+        explicit accelerator(const std::bitset<alphabet_size>& stays): accelerator()
+        {
+            std::size_t ch = 0;
+
+            while (ch < alphabet_size) {
+                if (not stays[ch]) {
+                    ch++;
+                    continue;
+                }
+
+                std::size_t low = ch;
+                while (ch < alphabet_size and stays[ch]) {
+                    ch++;
+                }
+
+                if (this->count == max_ranges) {
+                    this->count = 0;
+                    return;
+                }
+
+                this->lows[this->count].fill(static_cast<std::uint8_t>(low));
+                this->spans[this->count].fill(static_cast<std::uint8_t>(ch - 1 - low));
+                this->count++;
+            }
+
+            for (std::size_t i = this->count; i < max_ranges; i++) {
+                this->lows[i]  = this->lows[0];
+                this->spans[i] = this->spans[0];
+            }
+        }
+
+        inline bool empty(void) const noexcept
+        {
+            return this->count == 0;
+        }
+
+        inline std::size_t get_range_count(void) const noexcept
+        {
+            return this->count;
+        }
+
+        // 返回[p, end)中第一个不会让状态转换到自身的字节的位置, 没有时返回end
+        // 每段自环只调用一次, 不内联到DFA的内层循环中, 使内层循环保持足够小而能被内联
+        [[gnu::noinline]] const char* skip(const char* p, const char* end) const noexcept
+        {
+#if defined(__SSE2__)
+            const auto* lows  = reinterpret_cast<const __m128i*>(this->lows.data());
+            const auto* spans = reinterpret_cast<const __m128i*>(this->spans.data());
+
+            while (end - p >= 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                __m128i stays = _mm_setzero_si128();
+
+                // 无符号比较x - low <= span, 即min(x - low, span) == x - low
+                for (std::size_t i = 0; i < max_ranges; i++) {
+                    __m128i offset = _mm_sub_epi8(bytes, _mm_load_si128(lows + i));
+                    __m128i span   = _mm_load_si128(spans + i);
+                    stays          = _mm_or_si128(
+                        stays, _mm_cmpeq_epi8(_mm_min_epu8(offset, span), offset));
+                }
+
+                auto exits = static_cast<unsigned>(~_mm_movemask_epi8(stays)) & 0xffffu;
+                if (exits != 0) {
+                    return p + std::countr_zero(exits);
+                }
+
+                p += 16;
+            }
+#endif
+            while (p != end and this->contains(static_cast<unsigned char>(*p))) {
+                p++;
+            }
+
+            return p;
+        }
+    };
+
+} // namespace laxer
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "dfa_table.hpp"
+#include "interleaved.hpp"
+#include "nfa.hpp"
+#include "regex/regex.hpp"
+#include "rule.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+namespace laxer {
+
+    // 编译完成的词法分析器: 规则表和DFA表, 构造后不再修改
+    // 通过shared_ptr在多个线程的lexer_cursor之间共享, 规则回调会被同时调用, 必须是可重入的
+    class compiled_lexer {
+       private:
+        std::vector<rule> rules;
+        std::vector<std::string> mode_names;
+        dfa_table table;
+
+       public:
+        // nfas和mode_names以模式id为下标, 每个模式各自生成DFA后拼接到同一张表中
+        // strides为true时尝试生成两字节步长的转换表, 表过大时不生成
+        compiled_lexer(std::vector<rule> rules, const std::vector<nfa>& nfas,
+                       std::vector<std::string> mode_names, bool error_runs,
+                       bool strides = false)
+            : rules(std::move(rules)),
+              mode_names(std::move(mode_names)),
+              table {}
+        {
+            std::vector<nfa::dfa> dfas;
+            dfas.reserve(nfas.size());
+
+            for (const auto& mode_nfa : nfas) {
+                dfas.push_back(regex::build(mode_nfa));
+            }
+
+            this->table = dfa_table(dfas, this->rules);
+            this->table.set_error_runs(error_runs);
+
+            if (strides) {
+                this->table.build_strides();
+            }
+        }
+
+        // 返回只有错误区间开关不同的副本
+        std::shared_ptr<const compiled_lexer> with_error_runs(bool enabled) const
+        {
+            auto copy = std::make_shared<compiled_lexer>(*this);
+            copy->table.set_error_runs(enabled);
+
+            return copy;
+        }
+
+        // 返回生成或去掉两字节步长转换表的副本
+        std::shared_ptr<const compiled_lexer> with_strides(bool enabled) const
+        {
+            auto copy = std::make_shared<compiled_lexer>(*this);
+
+            if (enabled) {
+                copy->table.build_strides();
+            } else {
+                copy->table.clear_strides();
+            }
+
+            return copy;
+        }
+
+        inline const dfa_table& get_table(void) const noexcept
+        {
+            return this->table;
+        }
+
+        inline const std::vector<rule>& get_rules(void) const noexcept
+        {
+            return this->rules;
+        }
+
+        inline const rule& get_rule(token::id_t rule_id) const
+        {
+            return this->rules.at(rule_id);
+        }
+
+        inline std::size_t get_mode_count(void) const noexcept
+        {
+            return this->mode_names.size();
+        }
+
+        inline const std::string& get_mode_name(token::id_t mode) const
+        {
+            return this->mode_names.at(mode);
+        }
+
+        // token对应的规则名, 包括保留的EOF和default
+        std::string_view get_rule_name(const token& tok) const
+        {
+            if (tok.is_eof()) {
+                return "EOF";
+            }
+
+            if (tok.is_default()) {
+                return "default";
+            }
+
+            return this->get_rule(tok.get_rule_id()).get_name();
+        }
+
+        // 交错地对许多互相独立的短输入分别进行词法分析, 第i个结果对应inputs[i]
+        inline std::vector<token_columns> tokenize_many(
+            std::span<const std::string_view> inputs, bool with_values = false,
+            std::size_t lane_count = interleaved_lexer::default_lane_count) const
+        {
+            return interleaved_lexer::tokenize(this->table, this->rules, inputs,
+                                               with_values, lane_count);
+        }
+    };
+
+} // namespace laxer
@@ -0,0 +1,654 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "accelerator.hpp"
+#include "nfa.hpp"
+#include "rule.hpp"
+#include "shuffle_dfa.hpp"
+#include "token.hpp"
+
+namespace laxer {
+
+    // 由DFA编译得到的扁平转换表, 词法分析的内层循环只访问这张表
+    class dfa_table {
+       public:
+        using id_t = nfa::dfa::id_t;
+
+        inline static constexpr id_t invalid_state = std::numeric_limits<id_t>::max();
+        inline static constexpr std::size_t alphabet_size =
+            std::numeric_limits<unsigned char>::max() + 1;
+
+        // 输入缓冲区末尾的哨兵字节, 表中任何状态在哨兵上都没有转换,
+        // 因此内层循环走到缓冲区末尾时自然停止, 无需逐字节检查输入结束
+        inline static constexpr char sentinel = '\0';
+
+        // 两字节步长转换表默认的最大项数
+        inline static constexpr std::size_t default_max_stride_entries = 1 << 20;
+
+       private:
+        // transitions[state * alphabet_size + byte]
+        std::vector<id_t> transitions;
+        // 各状态在哨兵字节上的真实转换, 仅在输入中确实出现哨兵字节时查询
+        std::vector<id_t> sentinel_transitions;
+        // 各状态接受的规则id, 非终态为invalid_state
+        std::vector<id_t> accepts;
+        // 各模式的起始状态, 以模式id为下标
+        std::vector<id_t> starts;
+        // 跳过规则匹配后切换到的模式, 以规则id为下标; 不是跳过规则时为not_skip
+        std::vector<id_t> skip_modes;
+        // 各模式下能作为token第一个字节的字节, first_bytes[mode * alphabet_size + byte]
+        std::vector<std::uint8_t> first_bytes;
+        // 是否把连续的无法匹配的字节合并为一个错误token
+        bool error_runs;
+        // 有加速器的状态的加速器, 以及各状态的加速器在其中的下标, 没有加速器时为invalid_state
+        std::vector<accelerator> accelerators;
+        std::vector<id_t> accelerator_ids;
+
+        // 两字节步长的转换: 一次查表消耗两个字节
+        struct stride_t
+        {
+            // 消耗length个字节后的状态, 以及该状态在strides中的起始下标
+            id_t state;
+            std::uint32_t row;
+            // 消耗的字节中最后一次到达的终态接受的规则id, accept_length为0表示没有
+            id_t accept;
+            // length为0或1表示在第1或第2个字节上没有转换
+            std::uint8_t length;
+            std::uint8_t accept_length;
+        };
+
+        // 字节等价类, 在所有状态上转换都相同的字节属于同一类
+        // first_classes为第1个字节的类乘以类数, 与second_classes相加即为状态内的下标
+        std::vector<std::uint32_t> first_classes;
+        std::vector<std::uint32_t> second_classes;
+        std::size_t class_count;
+        // strides[状态 * 类数 * 类数 + 第1个字节的类 * 类数 + 第2个字节的类]
+        std::vector<stride_t> strides;
+
+        // 状态数很少时使用字节重排指令模拟的转换表, 存在时代替主表扫描
+        std::optional<shuffle_dfa> shuffle;
+
+        inline static constexpr id_t not_skip = invalid_state - 1;
+
+        // 包括哨兵字节在内的真实转换
+        inline id_t next_real(id_t state, std::size_t ch) const noexcept
+        {
+            return ch == static_cast<unsigned char>(sentinel)
+                     ? this->sentinel_transitions[state]
+                     : this->transitions[state * alphabet_size + ch];
+        }
+
+        // 以两字节步长扫描, 返回是否因为无效转换而停止; 剩余不足两个字节时返回false
+        bool advance_strides(const char* begin, const char* end, const char*& p,
+                             id_t& state, id_t& matched,
+                             std::size_t& matched_end) const noexcept
+        {
+            const std::uint32_t* first  = this->first_classes.data();
+            const std::uint32_t* second = this->second_classes.data();
+            const stride_t* strides     = this->strides.data();
+
+            // 全部使用局部变量, 避免经过引用的写入迫使编译器重新读取
+            const char* cur        = p;
+            const char* accept_end = nullptr;
+            id_t accept            = invalid_state;
+            stride_t stride {state, 0, invalid_state, 2, 0};
+
+            // 循环中只依赖上一次查表得到的起始下标, 不需要乘法
+            stride.row = static_cast<std::uint32_t>(state * this->class_count
+                                                    * this->class_count);
+
+            // 固定前移两个字节, 使下一次读取的字节不依赖本次查表的结果, 停止时再修正
+            while (end - cur >= 2 and stride.length == 2) {
+                stride = strides[stride.row + first[static_cast<unsigned char>(cur[0])]
+                                 + second[static_cast<unsigned char>(cur[1])]];
+
+                if (stride.accept_length != 0) {
+                    accept     = stride.accept;
+                    accept_end = cur + stride.accept_length;
+                }
+
+                cur += 2;
+            }
+
+            if (accept_end != nullptr) {
+                matched     = accept;
+                matched_end = static_cast<std::size_t>(accept_end - begin);
+            }
+
+            p     = cur - (2 - stride.length);
+            state = stride.state;
+
+            return stride.length != 2;
+        }
+
+        // 在主表上扫描, 与advance相同
+        std::size_t advance_table(std::string_view input, std::size_t offset, id_t& state,
+                                  id_t& matched, std::size_t& matched_end) const noexcept
+        {
+            const char* const begin = input.data();
+            const char* const end   = begin + input.size();
+            const char* p           = begin + offset;
+
+            id_t current_state = state;
+
+            if (this->has_strides()
+                and this->advance_strides(begin, end, p, current_state, matched,
+                                          matched_end)) {
+                state = current_state;
+
+                return static_cast<std::size_t>(p - begin);
+            }
+
+            // 全部使用局部变量, 结束后再写回
+            const char* accept_end = nullptr;
+            id_t accept            = invalid_state;
+            bool looped            = false;
+
+            while (p != end) {
+                auto next_state = this->next(current_state, *p);
+
+                // 输入中真实出现的哨兵字节
+                if (next_state == invalid_state and *p == sentinel) {
+                    next_state = this->next_sentinel(current_state);
+                }
+
+                // 持续匹配, 直到遇到无效状态
+                if (next_state == invalid_state) {
+                    break;
+                }
+
+                // 连续第二次自环且状态有加速器时, 直接跳到第一个离开该状态的字节;
+                // 第一次自环时仍逐字节前进, 避免很短的自环也付出启动加速器的开销
+                if (next_state == current_state and looped) [[unlikely]] {
+                    p = this->accelerate(current_state, p + 1, end);
+                } else {
+                    looped        = next_state == current_state;
+                    current_state = next_state;
+                    p++;
+                }
+
+                if (auto rule_id = this->get_accept(current_state);
+                    rule_id != invalid_state) {
+                    accept     = rule_id;
+                    accept_end = p;
+                }
+            }
+
+            if (accept_end != nullptr) {
+                matched     = accept;
+                matched_end = static_cast<std::size_t>(accept_end - begin);
+            }
+
+            state = current_state;
+
+            return static_cast<std::size_t>(p - begin);
+        }
+
+       public:
+        dfa_table(void)
+            : transitions {},
+              sentinel_transitions {},
+              accepts {},
+              starts {},
+              skip_modes {},
+              first_bytes {},
+              error_runs(false),
+              accelerators {},
+              accelerator_ids {},
+              first_classes {},
+              second_classes {},
+              class_count(0),
+              strides {},
+              shuffle {}
+        {
+        }
+
+        explicit dfa_table(const nfa::dfa& dfa): dfa_table(std::span(&dfa, 1))
+        {
+        }
+
+        // 把每个模式各自的DFA依次拼接到同一张表中, 模式之间的状态互不可达
+        // rules用于在表中标记跳过规则
+        explicit dfa_table(std::span<const nfa::dfa> dfas,
+                           std::span<const rule> rules = {})
+            : transitions {},
+              sentinel_transitions {},
+              accepts {},
+              starts {},
+              skip_modes(rules.size(), not_skip),
+              first_bytes {},
+              error_runs(false),
+              accelerators {},
+              accelerator_ids {},
+              first_classes {},
+              second_classes {},
+              class_count(0),
+              strides {},
+              shuffle {}
+        {
+            for (const auto& r : rules) {
+                if (r.is_skip()) {
+                    this->skip_modes[r.get_rule_id()] = r.get_next_mode();
+                }
+            }
+
+            std::size_t state_count = 0;
+            for (const auto& dfa : dfas) {
+                state_count += dfa.get_state_count();
+            }
+
+            this->transitions.assign(state_count * alphabet_size, invalid_state);
+            this->sentinel_transitions.assign(state_count, invalid_state);
+            this->accepts.assign(state_count, invalid_state);
+
+            id_t base = 0;
+
+            for (const auto& dfa : dfas) {
+                this->starts.push_back(base + dfa.get_start());
+
+                for (const auto& final : dfa.get_final()) {
+                    this->accepts[base + final] = final.get_rule_id();
+                }
+
+                const auto& states = dfa.get_states();
+
+                for (std::size_t state = 0; state < states.size(); state++) {
+                    const auto& transition_map = states[state].get_transition_map();
+
+                    std::transform(transition_map.begin(), transition_map.end(),
+                                   this->transitions.begin()
+                                       + (base + state) * alphabet_size,
+                                   [base](id_t to) {
+                                       return to == invalid_state ? to : base + to;
+                                   });
+
+                    // 把哨兵上的转换移出主表
+                    auto& sentinel_item =
+                        this->transitions[(base + state) * alphabet_size
+                                          + static_cast<unsigned char>(sentinel)];
+
+                    this->sentinel_transitions[base + state] = sentinel_item;
+                    sentinel_item                            = invalid_state;
+                }
+
+                base += static_cast<id_t>(states.size());
+            }
+
+            this->first_bytes.resize(this->starts.size() * alphabet_size);
+
+            for (std::size_t mode = 0; mode < this->starts.size(); mode++) {
+                auto start = this->starts[mode];
+
+                for (std::size_t ch = 0; ch < alphabet_size; ch++) {
+                    this->first_bytes[mode * alphabet_size + ch] =
+                        this->next(start, static_cast<char>(ch)) != invalid_state;
+                }
+
+                this->first_bytes[mode * alphabet_size
+                                  + static_cast<unsigned char>(sentinel)] =
+                    this->next_sentinel(start) != invalid_state;
+            }
+
+            this->accelerator_ids.assign(state_count, invalid_state);
+
+            // 主表中哨兵字节上没有转换, 因此加速器总是停在哨兵上
+            for (std::size_t state = 0; state < state_count; state++) {
+                std::bitset<alphabet_size> stays;
+                for (std::size_t ch = 0; ch < alphabet_size; ch++) {
+                    stays[ch] = this->transitions[state * alphabet_size + ch] == state;
+                }
+
+                accelerator acc(stays);
+                if (not acc.empty()) {
+                    this->accelerator_ids[state] =
+                        static_cast<id_t>(this->accelerators.size());
+                    this->accelerators.push_back(acc);
+                }
+            }
+
+            this->build_shuffle();
+        }
+
+        inline bool empty(void) const noexcept
+        {
+            return this->sentinel_transitions.empty();
+        }
+
+        inline id_t get_start(id_t mode = 0) const noexcept
+        {
+            return this->starts[mode];
+        }
+
+        inline std::size_t get_mode_count(void) const noexcept
+        {
+            return this->starts.size();
+        }
+
+        inline void set_error_runs(bool enabled) noexcept
+        {
+            this->error_runs = enabled;
+        }
+
+        inline bool get_error_runs(void) const noexcept
+        {
+            return this->error_runs;
+        }
+
+        // 生成两字节步长的转换表, 使长token的内层循环每次查表消耗两个字节
+        // 表的大小为状态数乘以字节等价类数的平方, 超过max_entries时不生成并返回false
+        bool build_strides(std::size_t max_entries = default_max_stride_entries)
+        {
+            std::size_t state_count = this->get_state_count();
+
+            // 按各状态上的转换划分字节等价类, columns[类]为该类字节在各状态上的转换
+            std::vector<std::vector<id_t>> columns;
+            std::map<std::vector<id_t>, std::uint8_t> class_ids;
+            std::vector<std::uint8_t> classes(alphabet_size);
+
+            for (std::size_t ch = 0; ch < alphabet_size; ch++) {
+                std::vector<id_t> column(state_count);
+                for (std::size_t state = 0; state < state_count; state++) {
+                    column[state] = this->next_real(static_cast<id_t>(state), ch);
+                }
+
+                auto id             = static_cast<std::uint8_t>(columns.size());
+                auto [it, inserted] = class_ids.try_emplace(column, id);
+                classes[ch] = it->second;
+
+                if (inserted) {
+                    columns.push_back(std::move(column));
+                }
+            }
+
+            std::size_t count = columns.size();
+
+            if (state_count * count * count > max_entries) {
+                return false;
+            }
+
+            std::vector<stride_t> result(state_count * count * count);
+            auto row_of = [count](std::size_t state) {
+                return static_cast<std::uint32_t>(state * count * count);
+            };
+
+            for (std::size_t state = 0; state < state_count; state++) {
+                for (std::size_t first = 0; first < count; first++) {
+                    for (std::size_t second = 0; second < count; second++) {
+                        auto& stride = result[row_of(state) + first * count + second];
+                        stride       = {static_cast<id_t>(state), row_of(state),
+                                        invalid_state, 0, 0};
+
+                        auto middle = columns[first][state];
+                        if (middle == invalid_state) {
+                            continue;
+                        }
+
+                        stride.state  = middle;
+                        stride.row    = row_of(middle);
+                        stride.length = 1;
+
+                        if (this->accepts[middle] != invalid_state) {
+                            stride.accept        = this->accepts[middle];
+                            stride.accept_length = 1;
+                        }
+
+                        auto last = columns[second][middle];
+                        if (last == invalid_state) {
+                            continue;
+                        }
+
+                        stride.state  = last;
+                        stride.row    = row_of(last);
+                        stride.length = 2;
+
+                        if (this->accepts[last] != invalid_state) {
+                            stride.accept        = this->accepts[last];
+                            stride.accept_length = 2;
+                        }
+                    }
+                }
+            }
+
+            this->first_classes.resize(alphabet_size);
+            this->second_classes.resize(alphabet_size);
+            for (std::size_t ch = 0; ch < alphabet_size; ch++) {
+                this->first_classes[ch]  =
+                    static_cast<std::uint32_t>(classes[ch] * count);
+                this->second_classes[ch] = classes[ch];
+            }
+
+            this->class_count = count;
+            this->strides     = std::move(result);
+
+            return true;
+        }
+
+        // 所有模式的状态总数小于16时生成字节重排转换表, 返回是否生成
+        bool build_shuffle(void)
+        {
+            if (this->empty() or not shuffle_dfa::fits(this->get_state_count())) {
+                return false;
+            }
+
+            this->shuffle.emplace(
+                this->get_state_count(), this->starts.front(),
+                [this](id_t state, std::size_t ch) { return this->next_real(state, ch); },
+                [this](id_t state) { return this->accepts[state]; });
+
+            for (std::size_t state = 0; state < this->get_state_count(); state++) {
+                if (auto acc = this->get_accelerator(static_cast<id_t>(state))) {
+                    this->shuffle->set_accelerator(static_cast<id_t>(state), *acc);
+                }
+            }
+
+            return true;
+        }
+
+        inline void clear_shuffle(void) noexcept
+        {
+            this->shuffle.reset();
+        }
+
+        inline bool has_shuffle(void) const noexcept
+        {
+            return this->shuffle.has_value();
+        }
+
+        // advance是否使用字节重排的内层循环
+        // 字节重排表在状态数小于16时自动生成, 显式生成的两字节步长表优先于它
+        inline bool uses_shuffle(void) const noexcept
+        {
+            return this->shuffle.has_value() and not this->has_strides();
+        }
+
+        inline void clear_strides(void) noexcept
+        {
+            this->first_classes.clear();
+            this->second_classes.clear();
+            this->class_count = 0;
+            this->strides.clear();
+        }
+
+        inline bool has_strides(void) const noexcept
+        {
+            return not this->strides.empty();
+        }
+
+        inline std::size_t get_class_count(void) const noexcept
+        {
+            return this->class_count;
+        }
+
+        // offset处没有规则能匹配时, 返回错误token的结束位置
+        // 未启用错误区间时只消耗一个字节; 启用时通过首字节表向后跳过不可能开始任何token的字节,
+        // complete表示input是完整的输入, 此时还会确认停下的位置确实能匹配, 否则继续扩展错误区间;
+        // reach更新为确定区间时读到的最远位置的下一个字节
+        std::size_t unmatched_end(std::string_view input, std::size_t offset, id_t mode,
+                                  bool complete, std::size_t& reach) const noexcept
+        {
+            std::size_t end = offset + 1;
+
+            if (not this->error_runs) {
+                return end;
+            }
+
+            const std::uint8_t* first = this->first_bytes.data() + mode * alphabet_size;
+
+            while (end < input.size()) {
+                while (end < input.size()
+                       and not first[static_cast<unsigned char>(input[end])]) {
+                    end++;
+                }
+
+                if (end == input.size() or not complete) {
+                    break;
+                }
+
+                id_t state              = this->starts[mode];
+                id_t matched            = invalid_state;
+                std::size_t matched_end = end;
+
+                std::size_t stop = this->advance(input, end, state, matched, matched_end);
+
+                reach = std::max(reach, stop + 1);
+
+                if (matched != invalid_state) {
+                    break;
+                }
+
+                end++;
+            }
+
+            reach = std::max(reach, end + 1);
+
+            return end;
+        }
+
+        inline std::size_t unmatched_end(std::string_view input, std::size_t offset,
+                                         id_t mode, bool complete = true) const noexcept
+        {
+            std::size_t reach = 0;
+
+            return this->unmatched_end(input, offset, mode, complete, reach);
+        }
+
+        // 规则是否为跳过规则, 是时按规则的要求更新mode
+        inline bool skip(id_t rule_id, id_t& mode) const noexcept
+        {
+            if (rule_id >= this->skip_modes.size()) {
+                return false;
+            }
+
+            auto next_mode = this->skip_modes[rule_id];
+
+            if (next_mode == not_skip) {
+                return false;
+            }
+
+            if (next_mode != token::keep_mode) {
+                mode = next_mode;
+            }
+
+            return true;
+        }
+
+        inline std::size_t get_state_count(void) const noexcept
+        {
+            return this->sentinel_transitions.size();
+        }
+
+        inline id_t next(id_t state, char ch) const noexcept
+        {
+            return this->transitions[state * alphabet_size
+                                     + static_cast<unsigned char>(ch)];
+        }
+
+        // 状态接受的规则id, 非终态返回invalid_state
+        inline id_t get_accept(id_t state) const noexcept
+        {
+            return this->accepts[state];
+        }
+
+        // 内层循环停在哨兵字节上时, 查询该字节作为普通输入时的转换
+        inline id_t next_sentinel(id_t state) const noexcept
+        {
+            return this->sentinel_transitions[state];
+        }
+
+        // 状态的加速器, 没有时返回nullptr
+        inline const accelerator* get_accelerator(id_t state) const noexcept
+        {
+            auto id = this->accelerator_ids[state];
+
+            return id == invalid_state ? nullptr : &this->accelerators[id];
+        }
+
+        // 位于状态state时跳过[p, end)中让状态转换到自身的字节,
+        // 返回第一个离开该状态的字节的位置; 没有加速器时原样返回p
+        inline const char* accelerate(id_t state, const char* p,
+                                      const char* end) const noexcept
+        {
+            auto id = this->accelerator_ids[state];
+
+            return id == invalid_state ? p : this->accelerators[id].skip(p, end);
+        }
+
+        // 从state开始继续扫描input中offset之后的部分, 直到遇到无效转换或输入结束,
+        // 返回停止的位置, state更新为停止前的状态;
+        // 经过终态时把接受的规则id和结束位置记录到matched与matched_end中
+        inline std::size_t advance(std::string_view input, std::size_t offset,
+                                   id_t& state, id_t& matched,
+                                   std::size_t& matched_end) const noexcept
+        {
+            if (this->uses_shuffle()) {
+                return this->shuffle->advance(input, offset, state, matched, matched_end);
+            }
+
+            return this->advance_table(input, offset, state, matched, matched_end);
+        }
+
+        // 在内存输入上从offset开始执行最长匹配
+        // 返回最后一次到达的终态所接受的规则id, 并通过matched_end返回匹配结束的位置;
+        // 没有规则能匹配时返回invalid_state, matched_end保持不变
+        id_t match(std::string_view input, std::size_t offset, std::size_t& matched_end,
+                   id_t mode = 0) const noexcept
+        {
+            id_t state   = this->starts[mode];
+            id_t matched = invalid_state;
+
+            this->advance(input, offset, state, matched, matched_end);
+
+            return matched;
+        }
+
+        // 与match相同, 但跳过规则匹配的部分在这里直接被消耗:
+        // offset前移到第一个非跳过token的起点, mode按跳过规则的要求更新;
+        // 返回后offset等于输入长度表示输入已经结束
+        id_t match_token(std::string_view input, std::size_t& offset,
+                         std::size_t& matched_end, id_t& mode) const noexcept
+        {
+            while (offset < input.size()) {
+                auto matched = this->match(input, offset, matched_end, mode);
+
+                if (matched == invalid_state or not this->skip(matched, mode)) {
+                    return matched;
+                }
+
+                offset = matched_end;
+            }
+
+            return invalid_state;
+        }
+    };
+
+} // namespace laxer
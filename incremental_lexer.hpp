@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "compiled_lexer.hpp"
+#include "dfa_table.hpp"
+#include "rule.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+namespace laxer {
+
+    // 文本的一次编辑: 从offset开始删除removed个字节, 再插入inserted
+    struct text_edit
+    {
+        std::size_t offset;
+        std::size_t removed;
+        std::string_view inserted;
+    };
+
+    // 增量词法分析器, 保存上一次的token流, 文本被编辑后只重新匹配受影响的部分
+    // 每个token记录匹配它以及它之前被回调丢弃的token时DFA读到的最远位置,
+    // 只有读到过编辑位置的token可能改变, 因此从第一个这样的token之前的边界开始重新匹配;
+    // 越过编辑区域后, 一旦新token的终点和之后的模式与旧token流中某个token相同,
+    // 之后的结果必然相同, 剩余的token只需移动偏移
+    class incremental_lexer {
+       public:
+        using id_t = token::id_t;
+
+        // 一次编辑后token流中被替换的区间: 从first开始的removed个旧token被替换为inserted个新token
+        struct change_t
+        {
+            std::size_t first;
+            std::size_t removed;
+            std::size_t inserted;
+        };
+
+       private:
+        // 共享的编译结果, laxer之后重新编译也不影响本对象
+        std::shared_ptr<const compiled_lexer> compiled;
+        // 缓存compiled中的DFA表和规则表, 避免匹配时经过shared_ptr
+        const dfa_table* table;
+        const std::vector<rule>* rules;
+        token_columns columns;
+        // reaches[i]为匹配第i个token及其之前被丢弃的token时读到的最远位置的下一个字节
+        std::vector<std::size_t> reaches;
+        // 第i个token之后所处的模式
+        std::vector<id_t> modes;
+        // 上一次匹配的文本, 调用者修改后只用它的地址和长度
+        std::string_view text;
+
+        // 匹配offset处的一个token并前移offset, 返回token是否被记录
+        bool lex_one(std::string_view text, std::size_t& offset, id_t& mode,
+                     std::size_t& reach, token_columns& output) const
+        {
+            auto state              = this->table->get_start(mode);
+            auto matched            = dfa_table::invalid_state;
+            std::size_t matched_end = offset;
+            std::size_t stop =
+                this->table->advance(text, offset, state, matched, matched_end);
+
+            // 停止位置的字节已经被读过; 停在输入末尾时读到的是EOF
+            reach = std::max(reach, stop + 1);
+
+            const rule* matched_rule = nullptr;
+
+            if (matched == dfa_table::invalid_state) {
+                matched_end = this->table->unmatched_end(text, offset, mode, true, reach);
+            } else {
+                matched_rule = &(*this->rules)[matched];
+            }
+
+            bool kept = output.push_match(
+                matched_rule, text.substr(offset, matched_end - offset), offset, mode);
+            offset    = matched_end;
+
+            return kept;
+        }
+
+       public:
+        explicit incremental_lexer(std::shared_ptr<const compiled_lexer> compiled,
+                                   bool with_values = false)
+            : compiled(std::move(compiled)),
+              table(&this->compiled->get_table()),
+              rules(&this->compiled->get_rules()),
+              columns(with_values),
+              reaches {},
+              modes {},
+              text {}
+        {
+        }
+
+        // 丢弃之前的结果, 完整匹配text
+        void lex(std::string_view text)
+        {
+            this->columns.clear();
+            this->reaches.clear();
+            this->modes.clear();
+            this->text = {};
+
+            this->apply(text, {0, 0, text});
+        }
+
+        // text为应用edit之后的完整文本, 返回token流中被替换的区间
+        // 值列中的字符串值指向最近一次传入的文本
+        change_t apply(std::string_view text, const text_edit& edit)
+        {
+            const auto text_size = this->text.size();
+
+            if (edit.offset + edit.removed > text_size
+                or text.size() != text_size - edit.removed + edit.inserted.size()) {
+                throw std::out_of_range("edit does not match the lexed text");
+            }
+
+            const auto offsets = this->columns.get_offsets();
+            const auto lengths = this->columns.get_lengths();
+
+            // 第一个读到过编辑位置的token, 从它之前的token结束处重新开始
+            std::size_t first =
+                std::ranges::find_if(this->reaches,
+                                     [&edit](std::size_t reach) {
+                                         return reach > edit.offset;
+                                     })
+                - this->reaches.begin();
+            std::size_t offset = first == 0 ? 0 : offsets[first - 1] + lengths[first - 1];
+
+            std::size_t edit_end = edit.offset + edit.inserted.size();
+            std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(edit.inserted.size())
+                                 - static_cast<std::ptrdiff_t>(edit.removed);
+
+            token_columns relexed(this->columns.has_values());
+            std::vector<std::size_t> relexed_reaches;
+            std::vector<id_t> relexed_modes;
+            std::size_t reach = 0;
+            std::size_t old   = first;
+            id_t mode         = first == 0 ? token::initial_mode : this->modes[first - 1];
+            bool synced       = false;
+
+            while (offset < text.size() and not synced) {
+                if (not this->lex_one(text, offset, mode, reach, relexed)) {
+                    continue;
+                }
+
+                relexed_reaches.push_back(std::exchange(reach, 0));
+                relexed_modes.push_back(mode);
+
+                if (offset < edit_end) {
+                    continue;
+                }
+
+                // 在旧token流中寻找终点相同的token, 之后的模式也相同时即重新同步
+                std::size_t old_end = offset - edit.inserted.size() + edit.removed;
+
+                while (old < offsets.size() and offsets[old] + lengths[old] < old_end) {
+                    old++;
+                }
+
+                if (old < offsets.size() and offsets[old] + lengths[old] == old_end
+                    and this->modes[old] == mode) {
+                    synced = true;
+                    old++;
+                }
+            }
+
+            if (not synced) {
+                old = offsets.size();
+            }
+
+            this->columns.shift(old, delta);
+            // 保留的token的字符串值仍然指向旧文本
+            if (this->columns.has_values()) {
+                this->columns.rebase_values(this->text, text, old, delta);
+            }
+
+            for (std::size_t i = old; i < this->reaches.size(); i++) {
+                this->reaches[i] += delta;
+            }
+
+            this->columns.replace(first, old - first, relexed);
+
+            auto splice = [first, old](auto& column, const auto& replacement) {
+                auto begin = column.begin() + first;
+                column.insert(column.erase(begin, begin + (old - first)),
+                              replacement.begin(), replacement.end());
+            };
+
+            splice(this->reaches, relexed_reaches);
+            splice(this->modes, relexed_modes);
+
+            this->text = text;
+
+            return {first, old - first, relexed.size()};
+        }
+
+        inline const token_columns& get_columns(void) const noexcept
+        {
+            return this->columns;
+        }
+    };
+
+} // namespace laxer
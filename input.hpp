@@ -0,0 +1,430 @@
+#pragma once
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+// windows.h默认定义的min/max宏会破坏std::max和numeric_limits<T>::max()
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "dfa_table.hpp"
+
+namespace laxer {
+
+    // 流输入的分块缓冲区
+    // 按块从streambuf中读取数据, 窗口[0, size)之后紧跟一个哨兵字节;
+    // 补充数据时保留调用者指定位置之后的数据, 使跨块的token在缓冲区中保持连续
+    // 启用预读后由后台线程在词法分析当前窗口的同时读入下一块, 补充时交换缓冲区,
+    // 只需要把跨块的token拷贝到新缓冲区前部预留的空间中
+    class stream_input {
+       public:
+        inline static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+       private:
+        // 后台预读的状态, 单独分配使stream_input可以移动
+        // 析构时先通知预读线程退出再汇合, 移动赋值覆盖旧状态时同样如此
+        // 正在进行的sgetn无法被打断, 汇合会等到这次读取返回为止
+        struct prefetch_t
+        {
+            std::mutex lock;
+            std::condition_variable changed;
+            // [0, chunk_size)为跨块token预留的空间, 数据从chunk_size开始写入
+            std::vector<char> buffer;
+            std::streamsize count;
+            std::exception_ptr error;
+            bool requested;
+            bool ready;
+            bool stopping;
+            // 必须最后声明, 析构时先汇合预读线程
+            std::jthread worker;
+
+            ~prefetch_t()
+            {
+                {
+                    std::lock_guard guard(this->lock);
+                    this->stopping = true;
+                }
+
+                this->changed.notify_all();
+            }
+        };
+
+        std::streambuf* source;
+        std::vector<char> storage;
+        std::size_t chunk_size;
+        // 窗口在storage中的起始位置和有效字节数
+        std::size_t start;
+        std::size_t size;
+        // 窗口起始在整个输入中的偏移
+        std::size_t base;
+        bool exhausted;
+        std::unique_ptr<prefetch_t> prefetch;
+
+        // 预读线程: 每次被请求时读入一块数据
+        static void read_ahead(std::streambuf* source, std::size_t chunk_size,
+                               prefetch_t& state)
+        {
+            std::unique_lock guard(state.lock);
+
+            while (true) {
+                state.changed.wait(guard, [&state] {
+                    return state.requested or state.stopping;
+                });
+
+                if (state.stopping) {
+                    return;
+                }
+
+                // 读取期间不持有锁, 此时只有本线程访问buffer
+                guard.unlock();
+
+                std::streamsize count = 0;
+                std::exception_ptr error;
+                try {
+                    count = source->sgetn(state.buffer.data() + chunk_size,
+                                          static_cast<std::streamsize>(chunk_size));
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                guard.lock();
+                state.count     = count;
+                state.error     = error;
+                state.requested = false;
+                state.ready     = true;
+                state.changed.notify_all();
+            }
+        }
+
+        void request_prefetch(void)
+        {
+            auto& state = *this->prefetch;
+
+            // 缓冲区可能在长token时被扩大过, 交换回来后需要恢复大小
+            if (state.buffer.size() < 2 * this->chunk_size + 1) {
+                state.buffer.resize(2 * this->chunk_size + 1);
+            }
+
+            std::lock_guard guard(state.lock);
+            state.requested = true;
+            state.ready     = false;
+            state.changed.notify_all();
+        }
+
+        // 等待预读完成, 返回读到的字节数
+        std::size_t wait_prefetch(void)
+        {
+            auto& state = *this->prefetch;
+            std::unique_lock guard(state.lock);
+
+            state.changed.wait(guard, [&state] {
+                return state.ready;
+            });
+
+            if (state.error) {
+                std::rethrow_exception(state.error);
+            }
+
+            return state.count > 0 ? static_cast<std::size_t>(state.count) : 0;
+        }
+
+        // 把预读的count个字节接在窗口中keep之后剩余的remain个字节之后
+        void take_prefetch(std::size_t keep, std::size_t remain, std::size_t count)
+        {
+            auto& buffer = this->prefetch->buffer;
+            char* kept   = this->storage.data() + this->start + keep;
+
+            // 跨块的token不超过预留空间时交换缓冲区, 否则把新数据拷贝到当前缓冲区
+            if (remain <= this->chunk_size) {
+                std::size_t new_start = this->chunk_size - remain;
+
+                std::memcpy(buffer.data() + new_start, kept, remain);
+                std::swap(this->storage, buffer);
+                this->start = new_start;
+            } else {
+                std::memmove(this->storage.data(), kept, remain);
+                this->start = 0;
+
+                if (this->storage.size() < remain + count + 1) {
+                    this->storage.resize(remain + count + 1);
+                }
+
+                std::memcpy(this->storage.data() + remain,
+                            buffer.data() + this->chunk_size, count);
+            }
+
+            this->size = remain + count;
+        }
+
+       public:
+        // prefetch为true时启动后台线程预读, 之后source只由该线程访问
+        // 预读线程可能阻塞在source的读取中, 析构时必须等它返回:
+        // 只应对读取总会返回的源(文件, 内存等)启用预读, 管道或套接字等
+        // 可能无限期阻塞的源在数据到来或对端关闭前提前析构会一直挂起
+        explicit stream_input(std::streambuf* source,
+                              std::size_t chunk_size = default_chunk_size,
+                              bool prefetch          = false)
+            : source(source),
+              storage(chunk_size + 1, dfa_table::sentinel),
+              chunk_size(chunk_size),
+              start(0),
+              size(0),
+              base(0),
+              exhausted(source == nullptr),
+              prefetch {}
+        {
+            if (prefetch and not this->exhausted) {
+                this->prefetch = std::make_unique<prefetch_t>();
+                this->prefetch->worker = std::jthread(read_ahead, source, chunk_size,
+                                                      std::ref(*this->prefetch));
+                this->request_prefetch();
+            }
+        }
+
+        stream_input(stream_input&&)            = default;
+        stream_input& operator=(stream_input&&) = default;
+
+        // 当前窗口, 窗口之后的一个字节必然是哨兵
+        inline std::string_view window(void) const noexcept
+        {
+            return {this->storage.data() + this->start, this->size};
+        }
+
+        inline std::size_t get_base(void) const noexcept
+        {
+            return this->base;
+        }
+
+        // 丢弃窗口中keep之前的数据并读入下一块, 返回是否读到了新数据
+        // 调用后窗口中的所有位置都向前移动keep个字节
+        bool refill(std::size_t keep)
+        {
+            std::size_t remain  = this->size - keep;
+            this->base         += keep;
+
+            if (this->prefetch and not this->exhausted) {
+                std::size_t count = this->wait_prefetch();
+
+                if (count != 0) {
+                    this->take_prefetch(keep, remain, count);
+                    this->storage[this->start + this->size] = dfa_table::sentinel;
+                    this->request_prefetch();
+
+                    return true;
+                }
+
+                this->exhausted = true;
+            }
+
+            // 窗口之后的哨兵位置不变, 只需移动窗口起点
+            if (this->exhausted) {
+                this->start += keep;
+                this->size   = remain;
+
+                return false;
+            }
+
+            if (this->start + keep != 0 and remain != 0) {
+                std::memmove(this->storage.data(),
+                             this->storage.data() + this->start + keep, remain);
+            }
+
+            this->start                = 0;
+            this->size                 = remain;
+            this->storage[this->size]  = dfa_table::sentinel;
+
+            // 当前token比一块还长时扩大缓冲区
+            if (this->storage.size() < this->size + this->chunk_size + 1) {
+                this->storage.resize(this->size + this->chunk_size + 1);
+            }
+
+            auto count =
+                this->source->sgetn(this->storage.data() + this->size,
+                                    static_cast<std::streamsize>(this->chunk_size));
+
+            if (count <= 0) {
+                this->exhausted = true;
+                count           = 0;
+            }
+
+            this->size                += static_cast<std::size_t>(count);
+            this->storage[this->size]  = dfa_table::sentinel;
+
+            return count > 0;
+        }
+    };
+
+    // 只读映射整个文件, 词法分析直接在映射的内存上进行
+    // 避免了拷贝到流缓冲区以及逐字节的虚函数调用
+    class mapped_file {
+       private:
+        const char* data;
+        std::size_t size;
+
+        // 必须在关闭句柄之前获取错误码, 关闭操作可能会覆盖errno/GetLastError
+        static std::error_code last_error(void) noexcept
+        {
+#if defined(_WIN32)
+            return {static_cast<int>(::GetLastError()), std::system_category()};
+#else
+            return {errno, std::generic_category()};
+#endif
+        }
+
+        [[noreturn]]
+        static void throw_error(const std::filesystem::path& path, const char* what,
+                                std::error_code ec = last_error())
+        {
+            throw std::system_error(ec, std::format("{} {}", what, path.string()));
+        }
+
+       public:
+        explicit mapped_file(const std::filesystem::path& path): data(nullptr), size(0)
+        {
+#if defined(_WIN32)
+            HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                        nullptr, OPEN_EXISTING,
+                                        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                throw_error(path, "open");
+            }
+
+            LARGE_INTEGER file_size;
+            if (not ::GetFileSizeEx(file, &file_size)) {
+                const auto ec = last_error();
+                ::CloseHandle(file);
+                throw_error(path, "stat", ec);
+            }
+
+            this->size = static_cast<std::size_t>(file_size.QuadPart);
+
+            // 空文件无法映射
+            if (this->size != 0) {
+                std::error_code ec;
+                HANDLE mapping =
+                    ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping != nullptr) {
+                    this->data = static_cast<const char*>(
+                        ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    if (this->data == nullptr) {
+                        ec = last_error();
+                    }
+                    ::CloseHandle(mapping);
+                } else {
+                    ec = last_error();
+                }
+
+                if (this->data == nullptr) {
+                    ::CloseHandle(file);
+                    throw_error(path, "mmap", ec);
+                }
+            }
+
+            ::CloseHandle(file);
+#else
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw_error(path, "open");
+            }
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                const auto ec = last_error();
+                ::close(fd);
+                throw_error(path, "stat", ec);
+            }
+
+            this->size = static_cast<std::size_t>(st.st_size);
+
+            // 空文件无法映射
+            if (this->size != 0) {
+                void* addr = ::mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr == MAP_FAILED) {
+                    const auto ec = last_error();
+                    ::close(fd);
+                    throw_error(path, "mmap", ec);
+                }
+
+                // 词法分析顺序访问整个文件, 提示内核积极预读并及时回收已读页面
+                ::madvise(addr, this->size, MADV_SEQUENTIAL);
+                this->data = static_cast<const char*>(addr);
+            }
+
+            ::close(fd);
+#endif
+        }
+
+        mapped_file(const mapped_file&)            = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        mapped_file(mapped_file&& other) noexcept
+            : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0))
+        {
+        }
+
+        mapped_file& operator=(mapped_file&& other) noexcept
+        {
+            if (this != &other) {
+                this->unmap();
+                this->data = std::exchange(other.data, nullptr);
+                this->size = std::exchange(other.size, 0);
+            }
+
+            return *this;
+        }
+
+        ~mapped_file()
+        {
+            this->unmap();
+        }
+
+        inline std::string_view view(void) const noexcept
+        {
+            return {this->data, this->size};
+        }
+
+       private:
+        void unmap(void) noexcept
+        {
+            if (this->data == nullptr) {
+                return;
+            }
+
+#if defined(_WIN32)
+            ::UnmapViewOfFile(this->data);
+#else
+            ::munmap(const_cast<char*>(this->data), this->size);
+#endif
+            this->data = nullptr;
+            this->size = 0;
+        }
+    };
+
+} // namespace laxer
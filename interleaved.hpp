@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "dfa_table.hpp"
+#include "rule.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+namespace laxer {
+
+    // 交错地对多个互相独立的输入进行词法分析
+    // 同时推进lane_count个输入, 每一轮只让每个输入走一次转换;
+    // 各输入的查表互不依赖, 大DFA在缓存中未命中时多次访存可以重叠, 适合大量短记录
+    class interleaved_lexer {
+       public:
+        using id_t = token::id_t;
+
+        inline static constexpr std::size_t default_lane_count = 4;
+
+       private:
+        // 正在匹配的一个输入
+        struct lane_t
+        {
+            // 输入在inputs中的下标
+            std::size_t index;
+            std::string_view input;
+            // 当前token的起点和已经扫描到的位置
+            std::size_t start;
+            std::size_t pos;
+            id_t state;
+            id_t matched;
+            std::size_t matched_end;
+            id_t mode;
+        };
+
+        // 前移一个字节, 返回当前token是否已经结束
+        static inline bool step(const dfa_table& table, lane_t& lane) noexcept
+        {
+            if (lane.pos == lane.input.size()) {
+                return true;
+            }
+
+            char ch         = lane.input[lane.pos];
+            auto next_state = table.next(lane.state, ch);
+
+            // 输入中真实出现的哨兵字节
+            if (next_state == dfa_table::invalid_state and ch == dfa_table::sentinel) {
+                next_state = table.next_sentinel(lane.state);
+            }
+
+            if (next_state == dfa_table::invalid_state) {
+                return true;
+            }
+
+            lane.state = next_state;
+            lane.pos++;
+
+            // 记录接受状态用条件选择代替分支, 每次转换都会经过这里, 避免它的预测失败
+            // 丢弃其他通道已经发出的访存; 输入结束和死状态仍然是分支, 每个token只发生一次
+            auto accept      = table.get_accept(next_state);
+            bool accepted    = accept != dfa_table::invalid_state;
+            lane.matched     = accepted ? accept : lane.matched;
+            lane.matched_end = accepted ? lane.pos : lane.matched_end;
+
+            return false;
+        }
+
+        static inline void begin_token(const dfa_table& table, lane_t& lane,
+                                       std::size_t start) noexcept
+        {
+            lane.start   = start;
+            lane.pos     = start;
+            lane.state   = table.get_start(lane.mode);
+            lane.matched = dfa_table::invalid_state;
+        }
+
+        // 输出结束的token并开始下一个, 返回输入是否已经全部匹配
+        static bool finish_token(const dfa_table& table, const std::vector<rule>& rules,
+                                 lane_t& lane, token_columns& columns)
+        {
+            std::size_t end     = lane.matched_end;
+            const rule* matched = nullptr;
+
+            if (lane.matched == dfa_table::invalid_state) {
+                end = table.unmatched_end(lane.input, lane.start, lane.mode);
+            } else {
+                matched = &rules[lane.matched];
+            }
+
+            columns.push_match(matched, lane.input.substr(lane.start, end - lane.start),
+                               lane.start, lane.mode);
+            begin_token(table, lane, end);
+
+            return end == lane.input.size();
+        }
+
+       public:
+        // 交错推进lane_count个通道, 每轮让每个通道各走一次转换, 有token结束时再统一处理
+        template<std::size_t lane_count>
+        static void run(const dfa_table& table, const std::vector<rule>& rules,
+                        std::span<const std::string_view> inputs,
+                        std::vector<token_columns>& result)
+        {
+            std::size_t next_input = 0;
+            std::size_t active     = 0;
+            lane_t lanes[lane_count];
+            bool used[lane_count];
+
+            // 为空闲的通道取下一个非空输入, 没有剩余输入时返回false
+            auto load = [&](lane_t& lane) {
+                while (next_input < inputs.size() and inputs[next_input].empty()) {
+                    next_input++;
+                }
+
+                if (next_input == inputs.size()) {
+                    return false;
+                }
+
+                lane.index = next_input;
+                lane.input = inputs[next_input++];
+                lane.mode  = token::initial_mode;
+                begin_token(table, lane, 0);
+
+                return true;
+            };
+
+            for (std::size_t k = 0; k < lane_count; k++) {
+                used[k]  = load(lanes[k]);
+                active  += used[k];
+            }
+
+            while (active != 0) {
+                unsigned finished = 0;
+
+                for (std::size_t k = 0; k < lane_count; k++) {
+                    finished |= static_cast<unsigned>(used[k] and step(table, lanes[k]))
+                              << k;
+                }
+
+                for (std::size_t k = 0; finished != 0; k++, finished >>= 1) {
+                    auto& lane = lanes[k];
+
+                    if ((finished & 1) == 0
+                        or not finish_token(table, rules, lane, result[lane.index])
+                        or load(lane)) {
+                        continue;
+                    }
+
+                    used[k] = false;
+                    active--;
+                }
+            }
+        }
+
+       public:
+        // 分别对每个输入进行词法分析, 第i个结果与单独顺序匹配inputs[i]相同
+        // 规则回调按交错的顺序调用, 同一个输入的token仍然按顺序交给回调
+        // lane_count向上取为1, 2, 4, 8或16
+        static std::vector<token_columns> tokenize(
+            const dfa_table& table, const std::vector<rule>& rules,
+            std::span<const std::string_view> inputs, bool with_values = false,
+            std::size_t lane_count = default_lane_count)
+        {
+            std::vector<token_columns> result;
+            result.reserve(inputs.size());
+
+            for (const auto& input : inputs) {
+                result.emplace_back(with_values);
+                result.back().reserve(token_columns::estimated_capacity(input.size()));
+            }
+
+            if (lane_count <= 1) {
+                run<1>(table, rules, inputs, result);
+            } else if (lane_count <= 2) {
+                run<2>(table, rules, inputs, result);
+            } else if (lane_count <= 4) {
+                run<4>(table, rules, inputs, result);
+            } else if (lane_count <= 8) {
+                run<8>(table, rules, inputs, result);
+            } else {
+                run<16>(table, rules, inputs, result);
+            }
+
+            return result;
+        }
+    };
+
+} // namespace laxer
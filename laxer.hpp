@@ -1,118 +1,243 @@
 #pragma once
 
 #include <cstddef>
-#include <fstream>
-#include <stdexcept>
+#include <format>
+#include <memory>
 #include <streambuf>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "compiled_lexer.hpp"
+#include "dfa_table.hpp"
+#include "incremental_lexer.hpp"
+#include "input.hpp"
+#include "lexer_cursor.hpp"
 #include "nfa.hpp"
+#include "push_lexer.hpp"
 #include "regex/regex.hpp"
+#include "rule.hpp"
 #include "token.hpp"
+#include "token_columns.hpp"
 
 namespace laxer {
 
-    class laxer {
+    // 添加规则并在第一次匹配前编译, 同时作为自身输入上的游标使用
+    // 编译结果可以通过share取出, 供其他线程上的lexer_cursor共享
+    class laxer: public lexer_cursor {
        protected:
-        std::istream input_stream;
-        nfa nfa;
-        nfa::dfa dfa;
+        // 规则表, 以规则id为下标
+        std::vector<rule> rules;
+        // 每个模式各自的NFA, 以模式id为下标, 编译后拼接到同一张表中
+        std::vector<nfa> nfas;
+        std::vector<std::string> mode_names;
+        // 是否把连续的无法匹配的字节合并为一个错误token
+        bool error_runs;
+        // 是否生成两字节步长的转换表
+        bool strides;
 
        public:
-        class laxer_error: public std::runtime_error {
-           public:
-            explicit laxer_error(const std::string& msg): std::runtime_error(msg)
-            {
-            }
-        };
+        // 流输入模式, 按chunk_size分块读取, token文本在下一次调用next_token前有效
+        // prefetch为true时在后台线程上预读下一块, 使读取与词法分析重叠
+        laxer(std::streambuf* input,
+              std::size_t chunk_size = stream_input::default_chunk_size,
+              bool prefetch          = false)
+            : lexer_cursor(nullptr, input, chunk_size, prefetch),
+              rules {},
+              nfas(1),
+              mode_names {"INITIAL"},
+              error_runs(false),
+              strides(false)
+        {
+        }
 
-        laxer(std::streambuf* input): input_stream(input), nfa {}, dfa {}
+        // 内存输入模式, 调用者需保证input在laxer及其返回的token使用期间有效
+        laxer(std::string_view input = {})
+            : lexer_cursor(nullptr, input),
+              rules {},
+              nfas(1),
+              mode_names {"INITIAL"},
+              error_runs(false),
+              strides(false)
         {
         }
 
+        // 添加在初始模式中生效的规则
         inline void add_rule(const std::string& regex, nfa::id_t token_id = 0,
                              const token::action_t& cb = {}, std::string name = {})
         {
-            this->nfa.add_nfa(regex::build_nfa(regex), token_id, cb, name);
+            this->add_mode_rule({token::initial_mode}, regex, token_id, cb,
+                                std::move(name));
+        }
+
+        // 添加只在modes中生效的规则, 匹配后切换到next_mode;
+        // 回调也可以通过token::set_next_mode切换模式
+        void add_mode_rule(const std::vector<token::id_t>& modes,
+                           const std::string& regex, nfa::id_t token_id = 0,
+                           const token::action_t& cb = {}, std::string name = {},
+                           token::id_t next_mode = token::keep_mode)
+        {
+            this->add_compiled_rule(modes, regex, token_id, std::move(name), cb,
+                                    next_mode, false);
+        }
+
+        // 添加在初始模式中生效的跳过规则, 匹配的字节在匹配循环中直接被消耗,
+        // 不构造token, 不调用回调, 适用于空白和注释
+        inline void add_skip_rule(const std::string& regex, std::string name = {})
+        {
+            this->add_mode_skip_rule({token::initial_mode}, regex, std::move(name));
+        }
+
+        // 添加只在modes中生效的跳过规则, 匹配后切换到next_mode
+        void add_mode_skip_rule(const std::vector<token::id_t>& modes,
+                                const std::string& regex, std::string name = {},
+                                token::id_t next_mode = token::keep_mode)
+        {
+            this->add_compiled_rule(modes, regex, token::invalid_id, std::move(name), {},
+                                    next_mode, true);
+        }
+
+        // 添加一个新的模式, 返回模式id; 初始模式INITIAL的id为token::initial_mode
+        token::id_t add_mode(std::string name)
+        {
+            this->nfas.emplace_back();
+            this->mode_names.push_back(std::move(name));
+
+            return static_cast<token::id_t>(this->nfas.size() - 1);
+        }
+
+        inline const std::string& get_mode_name(token::id_t mode) const
+        {
+            return this->mode_names.at(mode);
+        }
+
+        // 从下一个token开始切换到mode
+        inline void set_mode(token::id_t mode)
+        {
+            if (mode >= this->nfas.size()) {
+                throw laxer_error(std::format("unknown mode {}", mode));
+            }
+
+            this->mode = mode;
+        }
+
+        inline const rule& get_rule(token::id_t rule_id) const
+        {
+            return this->rules.at(rule_id);
+        }
+
+        inline const auto& get_rules(void) const noexcept
+        {
+            return this->rules;
+        }
+
+        // 编译后的DFA表, 在第一次匹配或调用generate_dfa后生成, 之前为空表
+        inline const dfa_table& get_table(void) const noexcept
+        {
+            static const dfa_table empty_table;
+
+            return this->compiled_table ? *this->compiled_table : empty_table;
+        }
+
+        // token对应的规则名, 包括保留的EOF和default
+        std::string_view get_rule_name(const token& tok) const
+        {
+            if (tok.is_eof()) {
+                return "EOF";
+            }
+
+            if (tok.is_default()) {
+                return "default";
+            }
+
+            return this->get_rule(tok.get_rule_id()).get_name();
         }
 
+        // 编译当前的全部规则, 之后添加的规则需要再次调用才会生效
+        // 已经通过share取出的编译结果不受影响
         inline void generate_dfa(void)
         {
-            this->dfa = regex::build(this->nfa);
+            this->set_compiled(std::make_shared<const compiled_lexer>(
+                this->rules, this->nfas, this->mode_names, this->error_runs,
+                this->strides));
+        }
+
+        // 取出编译结果, 可以在任意线程上用它构造lexer_cursor
+        std::shared_ptr<const compiled_lexer> share(void)
+        {
+            this->prepare();
+
+            return this->compiled;
+        }
+
+        // 在input上创建共享本laxer编译结果的游标
+        inline lexer_cursor make_cursor(std::string_view input = {})
+        {
+            return lexer_cursor(this->share(), input);
+        }
+
+        // 启用后, 没有规则能匹配时不再逐字节返回default token,
+        // 而是把直到下一个能开始匹配的位置为止的字节合并为一个default token
+        inline void set_error_runs(bool enabled)
+        {
+            this->error_runs = enabled;
+
+            if (this->compiled) {
+                this->set_compiled(this->compiled->with_error_runs(enabled));
+            }
         }
 
-        token next_token(void)
+        // 启用后额外生成以字节等价类为下标的两字节步长转换表, 内层循环每次查表消耗两个字节,
+        // 缩短长token上相互依赖的查表链; 状态数乘以等价类数的平方过大时不生成
+        // 生成后优先于状态数小于16时自动使用的字节重排内层循环
+        inline void set_strides(bool enabled)
         {
-            if (this->dfa.get_states().empty()) {
-                this->generate_dfa();
+            this->strides = enabled;
 
-                if (this->dfa.get_states().empty()) {
-                    throw laxer_error("no valid rules");
-                }
+            if (this->compiled) {
+                this->set_compiled(this->compiled->with_strides(enabled));
             }
+        }
+
+        // 创建共享本laxer编译结果的推送式词法分析器, 用于由事件循环驱动的分块输入
+        // 返回的对象持有当前的编译结果, 之后修改laxer的规则或开关不影响它
+        push_lexer make_push_lexer(push_lexer::callback_t callback)
+        {
+            return push_lexer(this->share(), std::move(callback));
+        }
+
+        // 创建共享本laxer编译结果的增量词法分析器, 用于编辑器中反复修改的文本
+        // 返回的对象持有当前的编译结果, 之后修改laxer的规则或开关不影响它
+        incremental_lexer make_incremental_lexer(bool with_values = false)
+        {
+            return incremental_lexer(this->share(), with_values);
+        }
 
-            const auto& transition_map = this->dfa.get_states();
-            const auto& final_states   = this->dfa.get_final();
-
-            token cur_token(0, nfa::invalid_state);
-            bool is_return = false;
-
-            while (not is_return) {
-                std::string matched_text;
-                nfa::dfa::id_t current_state = this->dfa.get_start();
-
-                // 持续匹配, 直到遇到无效状态
-                while (current_state != nfa::invalid_state) {
-                    // 文件结束
-                    if (this->input_stream.eof()
-                        and cur_token.get_token_id() == nfa::invalid_state) {
-                        return token(nfa::invalid_state, nfa::invalid_state, {}, "EOF");
-                    }
-
-                    // 根据输入字符推动状态转换
-                    char current_char = this->input_stream.peek();
-
-                    auto next_state =
-                        transition_map[current_state].get_transition(current_char);
-
-                    // 匹配到某条规则
-                    auto it = final_states.find(next_state);
-                    if (it != final_states.end()) {
-                        // 记录匹配到的token
-                        if (it->get_token_id() != cur_token.get_token_id()) {
-                            cur_token = *it;
-                        }
-                    }
-
-                    // 下一状态不是无效状态
-                    if (next_state != nfa::invalid_state) {
-                        matched_text.push_back(current_char);
-                        this->input_stream.get();
-                    } else if (current_state == this->dfa.get_start()
-                               and next_state == nfa::invalid_state) {
-                        token default_token(nfa::invalid_state, nfa::invalid_state, {},
-                                            "default");
-                        matched_text.push_back(current_char);
-                        default_token.set_matched_text(std::move(matched_text));
-                        return default_token;
-                    }
-
-                    current_state = next_state;
-                }
-
-                // 设置与token对应的文本
-                cur_token.set_matched_text(std::move(matched_text));
-
-                // 调用回调来决定是否要返回这个token
-                auto action = cur_token.get_action();
-                if (action) {
-                    is_return = action(cur_token);
-                } else {
-                    // 没有写回调的情况下默认需要return;
-                    is_return = true;
-                }
+       protected:
+        void add_compiled_rule(const std::vector<token::id_t>& modes,
+                               const std::string& regex, nfa::id_t token_id,
+                               std::string name, const token::action_t& cb,
+                               token::id_t next_mode, bool skip)
+        {
+            auto rule_id  = static_cast<token::id_t>(this->rules.size());
+            auto rule_nfa = regex::build_nfa(regex);
+
+            for (auto mode : modes) {
+                this->nfas.at(mode).add_nfa(rule_nfa, rule_id);
             }
 
-            return cur_token;
+            this->rules.emplace_back(rule_id, token_id, std::move(name), cb, next_mode,
+                                     skip);
+        }
+
+        void compile(void) override
+        {
+            this->generate_dfa();
+
+            if (this->compiled_table->empty()) {
+                this->set_compiled(nullptr);
+                throw laxer_error("no valid rules");
+            }
         }
     };
 
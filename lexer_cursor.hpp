@@ -0,0 +1,523 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "compiled_lexer.hpp"
+#include "dfa_table.hpp"
+#include "input.hpp"
+#include "line_index.hpp"
+#include "nfa.hpp"
+#include "parallel.hpp"
+#include "rule.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+namespace laxer {
+
+    // 在一个输入上匹配token的游标, 只保存输入位置和当前模式, 规则和DFA来自共享的compiled_lexer
+    // 构造和reset都不涉及规则编译, 可以为每个请求创建; 不同线程应使用各自的游标
+    class lexer_cursor {
+       protected:
+        // 共享的编译结果, laxer在第一次匹配前才生成
+        std::shared_ptr<const compiled_lexer> compiled;
+        // 缓存compiled中的DFA表和规则表, 避免匹配时经过shared_ptr
+        const dfa_table* compiled_table;
+        const std::vector<rule>* compiled_rules;
+        // 当前输入窗口, 内存输入模式下为整个输入
+        std::string_view input_buffer;
+        // 下一个token在窗口中的位置
+        std::size_t input_offset;
+        // 流输入模式的分块缓冲区, 内存输入模式下为空
+        std::optional<stream_input> stream;
+        // 文件映射模式下持有的映射, input_buffer即为整个映射
+        std::optional<mapped_file> mapping;
+        // 当前所处的模式
+        token::id_t mode;
+        // 行号索引, 第一次查询位置时才扫描输入
+        std::optional<line_index> lines;
+
+       public:
+        class laxer_error: public std::runtime_error {
+           public:
+            explicit laxer_error(const std::string& msg): std::runtime_error(msg)
+            {
+            }
+        };
+
+        // 流输入模式, 按chunk_size分块读取, token文本在下一次调用next_token前有效
+        // prefetch为true时在后台线程上预读下一块, 使读取与词法分析重叠
+        lexer_cursor(std::shared_ptr<const compiled_lexer> compiled,
+                     std::streambuf* input,
+                     std::size_t chunk_size = stream_input::default_chunk_size,
+                     bool prefetch          = false)
+            : compiled {},
+              compiled_table(nullptr),
+              compiled_rules(nullptr),
+              input_buffer {},
+              input_offset(0),
+              stream(std::in_place, input, chunk_size, prefetch),
+              mapping {},
+              mode(token::initial_mode),
+              lines {}
+        {
+            this->set_compiled(std::move(compiled));
+        }
+
+        // 内存输入模式, 调用者需保证input在游标及其返回的token使用期间有效
+        explicit lexer_cursor(std::shared_ptr<const compiled_lexer> compiled,
+                              std::string_view input = {})
+            : compiled {},
+              compiled_table(nullptr),
+              compiled_rules(nullptr),
+              input_buffer(input),
+              input_offset(0),
+              stream {},
+              mapping {},
+              mode(token::initial_mode),
+              lines {}
+        {
+            this->set_compiled(std::move(compiled));
+        }
+
+        lexer_cursor(lexer_cursor&&)            = default;
+        lexer_cursor& operator=(lexer_cursor&&) = default;
+        virtual ~lexer_cursor(void)             = default;
+
+        // 切换到新的内存输入, 编译结果保持不变
+        void reset(std::string_view input) noexcept
+        {
+            this->input_buffer = input;
+            this->input_offset = 0;
+            this->mode         = token::initial_mode;
+            this->stream.reset();
+            this->mapping.reset();
+            this->lines.reset();
+        }
+
+        // 以只读方式映射文件并在映射上进行词法分析, token在切换输入前有效
+        void open(const std::filesystem::path& path)
+        {
+            this->reset({});
+            this->input_buffer = this->mapping.emplace(path).view();
+        }
+
+        // 是否为流输入模式, 此时token文本在下一次匹配后失效
+        inline bool is_streaming(void) const noexcept
+        {
+            return this->stream.has_value();
+        }
+
+        // 下一个token在输入中的字节偏移
+        std::size_t get_offset(void) const noexcept
+        {
+            return this->get_base() + this->input_offset;
+        }
+
+        // 输入中offset处的行号和列号, 用于报告错误位置
+        // 流输入模式下已经读过的输入不再保存, 无法查询
+        line_index::position_t locate(std::size_t offset)
+        {
+            if (this->is_streaming()) {
+                throw laxer_error("positions are unavailable for streamed input");
+            }
+
+            if (not this->lines) {
+                this->lines.emplace(this->input_buffer);
+            }
+
+            return this->lines->locate(offset);
+        }
+
+        inline line_index::position_t locate(const token& tok)
+        {
+            return this->locate(tok.get_offset());
+        }
+
+        inline token::id_t get_mode(void) const noexcept
+        {
+            return this->mode;
+        }
+
+        // 从下一个token开始切换到mode
+        inline void set_mode(token::id_t mode)
+        {
+            if (this->compiled and mode >= this->compiled->get_mode_count()) {
+                throw laxer_error(std::format("unknown mode {}", mode));
+            }
+
+            this->mode = mode;
+        }
+
+        // 共享的编译结果, laxer在第一次匹配或调用generate_dfa前为空
+        inline const std::shared_ptr<const compiled_lexer>& get_compiled(
+            void) const noexcept
+        {
+            return this->compiled;
+        }
+
+        token next_token(void)
+        {
+            this->prepare();
+
+            match_t match;
+
+            while (this->match_next(match)) {
+                // 没有规则能匹配, 将这个字节作为default token返回
+                if (match.matched_rule == nullptr) {
+                    return token(token::default_rule, token::invalid_id, match.text,
+                                 match.offset);
+                }
+
+                const auto& matched = *match.matched_rule;
+                token cur_token     = matched.make_token(match.text, match.offset);
+
+                // 调用回调来决定是否要返回这个token, 没有写回调的情况下默认需要return
+                const auto& action = matched.get_action();
+                bool kept          = not action or action(cur_token);
+
+                if (cur_token.get_next_mode() != token::keep_mode) {
+                    this->mode = cur_token.get_next_mode();
+                }
+
+                if (kept) {
+                    return cur_token;
+                }
+            }
+
+            return token(token::eof_rule, token::invalid_id, {}, this->get_offset());
+        }
+
+        // 惰性的token序列, 每次前移迭代器时才匹配下一个token, 遇到EOF结束
+        // 是单趟的输入视图, 可以与std::views组合; 流输入模式下token文本在前移后失效
+        class token_range: public std::ranges::view_interface<token_range> {
+           private:
+            lexer_cursor* owner;
+            token current;
+
+           public:
+            class iterator {
+               private:
+                token_range* range;
+
+               public:
+                using iterator_concept = std::input_iterator_tag;
+                using value_type       = token;
+                using difference_type  = std::ptrdiff_t;
+
+                iterator(void) noexcept: range(nullptr)
+                {
+                }
+
+                explicit iterator(token_range* range) noexcept: range(range)
+                {
+                }
+
+                inline const token& operator*(void) const noexcept
+                {
+                    return this->range->current;
+                }
+
+                inline const token* operator->(void) const noexcept
+                {
+                    return &this->range->current;
+                }
+
+                iterator& operator++(void)
+                {
+                    this->range->current = this->range->owner->next_token();
+                    return *this;
+                }
+
+                inline void operator++(int)
+                {
+                    ++*this;
+                }
+
+                inline bool operator==(std::default_sentinel_t) const noexcept
+                {
+                    return this->range->current.is_eof();
+                }
+            };
+
+            explicit token_range(lexer_cursor* owner = nullptr) noexcept
+                : owner(owner),
+                  current {}
+            {
+            }
+
+            // 只能调用一次, 匹配第一个token
+            iterator begin(void)
+            {
+                this->current = this->owner->next_token();
+                return iterator(this);
+            }
+
+            inline std::default_sentinel_t end(void) const noexcept
+            {
+                return std::default_sentinel;
+            }
+        };
+
+        // 从当前位置开始惰性地匹配剩余输入
+        inline token_range tokens(void) noexcept
+        {
+            return token_range(this);
+        }
+
+        // 批量匹配至多max_count个token, 以列的形式追加到columns中, 返回实际追加的数量
+        // 只有带回调的规则才会构造token对象, 返回0表示输入结束
+        std::size_t next_tokens(token_columns& columns, std::size_t max_count)
+        {
+            this->prepare();
+
+            std::size_t count = 0;
+            match_t match;
+
+            while (count < max_count and this->match_next(match)) {
+                if (columns.push_match(match.matched_rule, match.text, match.offset,
+                                       this->mode)) {
+                    // 流输入的字符串值指向窗口, 补充数据前拷贝到columns中
+                    if (this->stream and columns.has_values()) {
+                        columns.own_value(columns.size() - 1);
+                    }
+
+                    count++;
+                }
+            }
+
+            return count;
+        }
+
+        // 匹配剩余的全部输入
+        token_columns tokenize_all(bool with_values = false)
+        {
+            token_columns columns(with_values);
+
+            // 按平均token长度估计容量, 避免列在增长过程中反复拷贝
+            if (not this->stream) {
+                columns.reserve(token_columns::estimated_capacity(
+                    this->input_buffer.size() - this->input_offset));
+            }
+
+            this->next_tokens(columns, std::numeric_limits<std::size_t>::max());
+
+            return columns;
+        }
+
+        // 使用多个线程对剩余的内存输入进行推测式并行词法分析, 结果与tokenize_all相同
+        // 规则回调会在多个线程中同时调用, 必须是可重入的;
+        // 流输入无法切分, 使用多个模式时块的起始模式未知, 这两种情况退化为顺序匹配
+        token_columns tokenize_parallel(std::size_t thread_count = 0,
+                                        bool with_values         = false)
+        {
+            this->prepare();
+
+            if (this->stream or this->compiled_table->get_mode_count() > 1) {
+                return this->tokenize_all(with_values);
+            }
+
+            auto columns =
+                parallel_lexer::tokenize(*this->compiled_table, *this->compiled_rules,
+                                         this->input_buffer, this->input_offset,
+                                         thread_count, with_values);
+            this->input_offset = this->input_buffer.size();
+
+            return columns;
+        }
+
+       protected:
+        // 还没有编译结果时在第一次匹配前调用, laxer在这里生成DFA
+        virtual void compile(void)
+        {
+            throw laxer_error("no valid rules");
+        }
+
+        inline void prepare(void)
+        {
+            if (not this->compiled) {
+                this->compile();
+            }
+        }
+
+        void set_compiled(std::shared_ptr<const compiled_lexer> compiled) noexcept
+        {
+            this->compiled = std::move(compiled);
+            this->compiled_table = nullptr;
+            this->compiled_rules = nullptr;
+
+            if (this->compiled) {
+                this->compiled_table = &this->compiled->get_table();
+                this->compiled_rules = &this->compiled->get_rules();
+            }
+        }
+
+        // 一次匹配的结果, matched_rule为nullptr时表示没有规则能匹配, 此时text为一个字节
+        struct match_t
+        {
+            const rule* matched_rule;
+            // 在整个输入中的偏移
+            std::size_t offset;
+            std::string_view text;
+        };
+
+        // 从当前位置匹配下一个token并前移, 输入结束时返回false
+        bool match_next(match_t& match)
+        {
+            std::size_t matched_end;
+            nfa::dfa::id_t accept;
+
+            while (true) {
+                // 流输入模式下窗口已耗尽时先补充数据
+                if (this->input_offset == this->input_buffer.size() and this->stream) {
+                    this->refill();
+                }
+
+                // 输入结束
+                if (this->input_offset == this->input_buffer.size()) {
+                    return false;
+                }
+
+                matched_end = this->input_offset;
+
+                if (not this->stream) {
+                    accept = this->compiled_table->match_token(this->input_buffer,
+                                                     this->input_offset, matched_end,
+                                                     this->mode);
+                    break;
+                }
+
+                accept = this->match_stream(matched_end);
+
+                // 跳过规则匹配的字节直接消耗, 继续匹配下一个token
+                if (accept == dfa_table::invalid_state
+                    or not this->compiled_table->skip(accept, this->mode)) {
+                    break;
+                }
+
+                this->input_offset = matched_end;
+            }
+
+            // 跳过规则消耗了剩余的全部输入
+            if (this->input_offset == this->input_buffer.size()) {
+                return false;
+            }
+
+            // 没有规则能匹配时消耗一个字节或一段错误区间, 流输入只在当前窗口内合并
+            if (accept == dfa_table::invalid_state) {
+                match.matched_rule = nullptr;
+                matched_end        = this->compiled_table->unmatched_end(
+                    this->input_buffer, this->input_offset, this->mode, not this->stream);
+            } else {
+                match.matched_rule = &(*this->compiled_rules)[accept];
+            }
+
+            // 补充数据后窗口可能发生移动, 因此在匹配结束后再计算文本
+            match.offset = this->get_offset();
+            match.text   = this->input_buffer.substr(this->input_offset,
+                                                     matched_end - this->input_offset);
+
+            this->input_offset = matched_end;
+
+            return true;
+        }
+
+        inline std::size_t get_base(void) const noexcept
+        {
+            return this->stream ? this->stream->get_base() : 0;
+        }
+
+        // 补充流输入的数据, 保留从当前token开始的数据, 返回是否读到了新数据
+        bool refill(void)
+        {
+            bool has_data      = this->stream->refill(this->input_offset);
+            this->input_buffer = this->stream->window();
+            this->input_offset = 0;
+
+            return has_data;
+        }
+
+        // 在流输入的窗口上执行最长匹配, 窗口末尾的哨兵使内层循环不需要检查输入结束
+        nfa::dfa::id_t match_stream(std::size_t& matched_end)
+        {
+            const char* begin = this->input_buffer.data();
+            const char* p     = begin + this->input_offset;
+
+            nfa::dfa::id_t current_state = this->compiled_table->get_start(this->mode);
+            nfa::dfa::id_t matched       = dfa_table::invalid_state;
+
+            while (true) {
+                const char* window_end = begin + this->input_buffer.size();
+                bool looped            = false;
+
+                for (auto next_state = this->compiled_table->next(current_state, *p);
+                     next_state != dfa_table::invalid_state;
+                     next_state = this->compiled_table->next(current_state, *p)) {
+                    // 连续第二次自环且状态有加速器时, 直接跳到第一个离开该状态的字节
+                    if (next_state == current_state and looped) {
+                        p = this->compiled_table->accelerate(current_state, p + 1,
+                                                             window_end);
+                    } else {
+                        looped        = next_state == current_state;
+                        current_state = next_state;
+                        p++;
+                    }
+
+                    if (auto accept = this->compiled_table->get_accept(current_state);
+                        accept != dfa_table::invalid_state) {
+                        matched     = accept;
+                        matched_end = static_cast<std::size_t>(p - begin);
+                    }
+                }
+
+                std::size_t scanned = static_cast<std::size_t>(p - begin);
+
+                // 停在窗口内部: 要么是真正的无效转换, 要么是输入中真实出现的哨兵字节
+                if (scanned != this->input_buffer.size()) {
+                    auto next_state = this->compiled_table->next_sentinel(current_state);
+
+                    if (*p != dfa_table::sentinel
+                        or next_state == dfa_table::invalid_state) {
+                        break;
+                    }
+
+                    current_state = next_state;
+                    p++;
+
+                    if (auto accept = this->compiled_table->get_accept(current_state);
+                        accept != dfa_table::invalid_state) {
+                        matched     = accept;
+                        matched_end = static_cast<std::size_t>(p - begin);
+                    }
+
+                    continue;
+                }
+
+                // 停在窗口末尾的哨兵上, 保留当前token的数据并读入下一块
+                std::size_t shift = this->input_offset;
+                bool has_data     = this->refill();
+
+                begin        = this->input_buffer.data();
+                p            = begin + scanned - shift;
+                matched_end -= shift;
+
+                if (not has_data) {
+                    break;
+                }
+            }
+
+            return matched;
+        }
+    };
+
+} // namespace laxer
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace laxer {
+
+    // 字节偏移到行号和列号的索引
+    // 词法分析的内层循环不跟踪行号, 需要报告位置时才扫描一遍输入, 记录每行的起始偏移,
+    // 之后每次查询是一次二分查找; 扫描用SIMD一次比较16个字节
+    class line_index {
+       public:
+        // 行号和列号都从1开始, 列号按字节计算
+        struct position_t
+        {
+            std::size_t line;
+            std::size_t column;
+
+            bool operator==(const position_t&) const = default;
+        };
+
+       private:
+        std::string_view text;
+        // 每行起始的字节偏移, 第一行从0开始; 为空表示还没有扫描
+        std::vector<std::size_t> line_starts;
+
+        template<typename F>
+        static void for_each_newline(std::string_view text, F&& found)
+        {
+            const char* begin = text.data();
+            const char* p     = begin;
+            const char* end   = begin + text.size();
+
+#if defined(__SSE2__)
+            const __m128i newlines = _mm_set1_epi8('\n');
+
+            while (end - p >= 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                auto mask     = static_cast<unsigned>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newlines)));
+
+                for (; mask != 0; mask &= mask - 1) {
+                    found(static_cast<std::size_t>(p - begin) + std::countr_zero(mask));
+                }
+
+                p += 16;
+            }
+#endif
+            for (; p != end; p++) {
+                if (*p == '\n') {
+                    found(static_cast<std::size_t>(p - begin));
+                }
+            }
+        }
+
+        void build(void)
+        {
+            this->line_starts.reserve(count_lines(this->text) + 1);
+            this->line_starts.push_back(0);
+
+            for_each_newline(this->text, [this](std::size_t offset) {
+                this->line_starts.push_back(offset + 1);
+            });
+        }
+
+       public:
+        // 调用者需保证text在索引使用期间有效, 构造时不扫描
+        explicit line_index(std::string_view text = {}) noexcept
+            : text(text), line_starts {}
+        {
+        }
+
+        // 换行符的个数
+        static std::size_t count_lines(std::string_view text) noexcept
+        {
+            std::size_t count = 0;
+            const char* p     = text.data();
+            const char* end   = p + text.size();
+
+#if defined(__SSE2__)
+            const __m128i newlines = _mm_set1_epi8('\n');
+
+            while (end - p >= 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                count += std::popcount(static_cast<unsigned>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newlines))));
+                p += 16;
+            }
+#endif
+            return count + static_cast<std::size_t>(std::count(p, end, '\n'));
+        }
+
+        // 第一次查询时扫描输入; offset可以等于输入长度, 表示输入末尾
+        position_t locate(std::size_t offset)
+        {
+            if (this->line_starts.empty()) {
+                this->build();
+            }
+
+            auto next = std::upper_bound(this->line_starts.begin(),
+                                         this->line_starts.end(), offset);
+            auto line = static_cast<std::size_t>(next - this->line_starts.begin());
+
+            return {line, offset - *(next - 1) + 1};
+        }
+
+        // 第line行(从1开始)的文本, 不包含换行符
+        std::string_view get_line(std::size_t line)
+        {
+            if (this->line_starts.empty()) {
+                this->build();
+            }
+
+            auto begin = this->line_starts.at(line - 1);
+            auto end   = line < this->line_starts.size() ? this->line_starts[line] - 1
+                                                         : this->text.size();
+
+            return this->text.substr(begin, end - begin);
+        }
+
+        // 行数, 以换行符结尾的输入最后有一个空行
+        std::size_t get_line_count(void)
+        {
+            if (this->line_starts.empty()) {
+                this->build();
+            }
+
+            return this->line_starts.size();
+        }
+
+        inline bool is_built(void) const noexcept
+        {
+            return not this->line_starts.empty();
+        }
+    };
+
+} // namespace laxer
@@ -1,48 +1,216 @@
-#include <any>
-#include <cstdint>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
 #include <format>
 #include <iostream>
-#include <fstream>
-#include <istream>
-#include <optional>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
+#include "input.hpp"
 #include "laxer.hpp"
-#include "regex/regex.hpp"
-#include "nfa.hpp"
+#include "parallel.hpp"
+#include "thread_pool.hpp"
 #include "token.hpp"
 
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    // 小于该大小的文件会与其他文件合并为一个任务, 减少调度开销
+    constexpr std::size_t batch_size = 1024 * 1024;
+
+    struct file_result
+    {
+        std::filesystem::path path;
+        std::size_t bytes;
+        std::size_t tokens;
+        double seconds;
+        std::string error;
+    };
+
+    void usage(const char* name)
+    {
+        std::cerr << std::format("usage: {} [-j threads] [-q] <file or directory>...\n",
+                                 name);
+    }
+
+    // 展开目录, 收集所有普通文件
+    void collect(const std::filesystem::path& path, std::vector<file_result>& files)
+    {
+        auto add = [&files](const std::filesystem::path& file, std::size_t size) {
+            files.push_back({file, size, 0, 0.0, {}});
+        };
+
+        if (std::filesystem::is_directory(path)) {
+            using iterator = std::filesystem::recursive_directory_iterator;
+
+            for (const auto& entry : iterator(path)) {
+                if (entry.is_regular_file()) {
+                    add(entry.path(), entry.file_size());
+                }
+            }
+        } else {
+            add(path, std::filesystem::file_size(path));
+        }
+    }
+
+    void add_rules(laxer::laxer& l)
+    {
+        l.add_rule("0x[a-fA-F0-9]+", 0, laxer::converter::hex, "hex numbers");
+        l.add_rule("0b[01]+", 1, laxer::converter::bin, "bin numbers");
+        l.add_rule("\\d+", 2, {}, "numbers");
+        l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 3, {}, "identifiers");
+        l.add_rule("\"[^\"]*\"", 4, {}, "strings");
+        l.add_rule("'[^']*'", 4, {}, "strings");
+        l.add_rule("[-+*/%<>=!&|^~.,;:?(){}[]", 5, {}, "operators");
+        l.add_rule("\\]", 5, {}, "operators");
+        l.add_skip_rule("[ \r\n\t]+", "ignores");
+    }
+
+    // 所有线程共享同一份编译好的DFA和规则表, 只读访问
+    void lex_file(const laxer::laxer& l, file_result& file)
+    {
+        auto begin = clock_type::now();
+
+        try {
+            laxer::mapped_file mapping(file.path);
+
+            auto columns =
+                laxer::parallel_lexer::tokenize(l.get_table(), l.get_rules(),
+                                                mapping.view(), 0, 1);
+
+            file.bytes  = mapping.view().size();
+            file.tokens = columns.size();
+        } catch (const std::exception& e) {
+            file.error = e.what();
+        }
+
+        file.seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+    }
+
+    std::string rates(std::size_t tokens, std::size_t bytes, double seconds)
+    {
+        if (seconds <= 0) {
+            return "-";
+        }
+
+        return std::format("{:.2f} Mtokens/s, {:.2f} MB/s", tokens / seconds / 1e6,
+                           bytes / seconds / 1e6);
+    }
+
+} // namespace
+
 int main(const int argc, const char** argv)
 {
-    (void) argc;
-    (void) argv;
+    std::size_t thread_count = 0;
+    bool quiet               = false;
+    std::vector<std::filesystem::path> paths;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+
+        if (arg == "-j") {
+            std::string_view value = i + 1 < argc ? argv[++i] : "";
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(),
+                                             thread_count);
+
+            if (ec != std::errc {} or end != value.data() + value.size()
+                or thread_count == 0) {
+                std::cerr << std::format("invalid thread count '{}'\n", value);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "-q") {
+            quiet = true;
+        } else if (arg == "-h" or arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else {
+            paths.emplace_back(arg);
+        }
+    }
+
+    if (paths.empty()) {
+        paths.emplace_back("../../../../edl_demo");
+    }
+
+    std::vector<file_result> files;
+
+    try {
+        for (const auto& path : paths) {
+            collect(path, files);
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << std::format("{}\n", e.what());
+        usage(argv[0]);
+        return 1;
+    }
+
+    laxer::laxer l;
+    add_rules(l);
+    l.generate_dfa();
 
-    std::ifstream file("../../../../edl_demo/numbers.edl");
-    laxer::laxer l(file.rdbuf());
+    // 大文件优先调度, 避免最后只剩一个大文件拖慢整体
+    std::vector<std::size_t> order(files.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+
+    std::ranges::stable_sort(order, std::ranges::greater {},
+                             [&files](std::size_t i) { return files[i].bytes; });
 
-    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
-    l.add_rule("0x[a-fA-F0-9]+", 1, laxer::converter::hex, "hex numbers");
-    l.add_rule("0b[01]+", 2, laxer::converter::bin, "bin numbers");
-    l.add_rule("[ \r\n\t]", 3, laxer::converter::ignore, "ignores");
-    l.add_rule(".", 4, laxer::converter::ignore, "error token");
+    laxer::thread_pool pool(thread_count);
+    auto begin = clock_type::now();
 
-    laxer::token token = l.next_token();
+    for (std::size_t i = 0; i < order.size();) {
+        std::vector<std::size_t> batch;
+        std::size_t bytes = 0;
 
-    while (token.get_token_id() != laxer::nfa::invalid_state) {
-        std::cout << std::format("{}\n", token);
+        do {
+            bytes += files[order[i]].bytes;
+            batch.push_back(order[i++]);
+        } while (i < order.size() and bytes < batch_size);
 
-        if (const auto intPtr = std::get_if<std::uint64_t>(&token.get_token_value())) {
-            if (token.get_token_id() == 1) {
-                std::cout << std::format("token value: 0x{:X}\n", *intPtr);
-            } else {
-                std::cout << std::format("token value: {}\n", *intPtr);
+        pool.submit([&l, &files, batch = std::move(batch)] {
+            for (auto index : batch) {
+                lex_file(l, files[index]);
             }
+        });
+    }
+
+    pool.wait();
+
+    double seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+
+    std::size_t total_tokens = 0, total_bytes = 0, failed = 0;
+
+    for (const auto& file : files) {
+        if (not file.error.empty()) {
+            failed++;
+            std::cerr << std::format("{}: {}\n", file.path.string(), file.error);
+            continue;
         }
 
-        token = l.next_token();
+        total_tokens += file.tokens;
+        total_bytes  += file.bytes;
+
+        if (not quiet) {
+            std::cout << std::format("{}: {} tokens, {} bytes, {:.3f} ms, {}\n",
+                                     file.path.string(), file.tokens, file.bytes,
+                                     file.seconds * 1e3,
+                                     rates(file.tokens, file.bytes, file.seconds));
+        }
     }
 
-    file.close();
+    std::cout << std::format("total: {} files, {} tokens, {} bytes, {:.3f} s on {} "
+                             "threads, {}\n",
+                             files.size() - failed, total_tokens, total_bytes, seconds,
+                             pool.size(), rates(total_tokens, total_bytes, seconds));
 
-    return 0;
+    return failed == 0 ? 0 : 1;
 }
@@ -6,22 +6,29 @@
 
 #include "regex/nfa.hpp"
 #include "regex_typedef.hpp"
-#include "token.hpp"
 
 namespace laxer {
-    class final_state_t {
+    // 自动机终态, 只记录该终态接受的规则id, 规则的元数据保存在规则表中
+    class final_state_t: public regex::final_state_t {
        public:
         using id_t = regex::id_t;
 
        private:
-        id_t state_id;
-        std::string rule_name;
-        // std::function<> action;
+        id_t rule_id;
 
        public:
+        final_state_t(id_t state_id = 0, id_t rule_id = 0)
+            : regex::final_state_t(state_id), rule_id(rule_id)
+        {
+        }
+
+        id_t get_rule_id(void) const noexcept
+        {
+            return this->rule_id;
+        }
     };
 
-    class nfa: public regex::basic_nfa<std::set<token>> {
+    class nfa: public regex::basic_nfa<std::set<final_state_t>> {
        public:
         using final_state_id_t = typename basic_nfa::final_state_id_t;
 
@@ -29,9 +36,8 @@ namespace laxer {
         {
         }
 
-        // 添加单个regex::nfa到当前NFA
-        void add_nfa(const regex::nfa& input_nfa, id_t token_id = 0,
-                     const token::action_t& cb = {}, std::string name = {})
+        // 添加单个regex::nfa到当前NFA, 先添加的规则优先级更高
+        void add_nfa(const regex::nfa& input_nfa, id_t rule_id)
         {
             auto offset = this->merge_states(input_nfa);
 
@@ -39,13 +45,8 @@ namespace laxer {
             this->add_epsilon_transition(this->get_start(),
                                          input_nfa.get_start() + offset);
 
-            // 自动生成规则名
-            if (name.empty()) {
-                name = std::format("rule_{}", token_id);
-            }
-
-            // 把input_nfa的终态添加到accept_states中, 并填充元数据
-            this->add_final(input_nfa.get_final() + offset, token_id, cb, name);
+            // 把input_nfa的终态添加到accept_states中, 并记录规则id
+            this->add_final(input_nfa.get_final() + offset, rule_id);
         }
 
         std::optional<final_state_id_t> find_final(const closure_t& states) const
@@ -104,7 +105,7 @@ namespace std {
                 auto key = this->get_state_str(nfa, state_id);
 
                 result +=
-                    std::format("{}: accept rule {}\n", key, final_state.get_rule_name());
+                    std::format("{}: accept rule {}\n", key, final_state.get_rule_id());
             }
 
             auto& states = nfa.get_states();
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+
+namespace laxer {
+
+    // 直接在token文本上解析数值, 不分配内存也不抛出异常, 溢出和非法字符通过错误码返回
+    // 十进制和二进制每次用一个64位整数处理8个字符; 出错时不修改value
+    class number_parser {
+       public:
+        enum class format_t { dec, hex, bin, fp64 };
+
+       private:
+        inline static constexpr std::uint64_t ones = 0x0101010101010101ull;
+
+        // 小端序时8个字符可以按顺序装入一个整数, 第一个字符在最低字节
+        inline static constexpr bool swar = std::endian::native == std::endian::little;
+
+        inline static constexpr auto hex_digits = [] {
+            std::array<std::uint8_t, 256> digits {};
+            digits.fill(0xff);
+
+            for (int i = 0; i < 10; i++) {
+                digits['0' + i] = static_cast<std::uint8_t>(i);
+            }
+            for (int i = 0; i < 6; i++) {
+                digits['a' + i] = static_cast<std::uint8_t>(10 + i);
+                digits['A' + i] = static_cast<std::uint8_t>(10 + i);
+            }
+
+            return digits;
+        }();
+
+        static std::uint64_t load(const char* p) noexcept
+        {
+            std::uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+
+            return word;
+        }
+
+        // 8个字节是否都是'0'到'9'
+        static bool eight_digits(std::uint64_t word) noexcept
+        {
+            auto high  = word & (0xf0 * ones);
+            auto carry = (word + 0x06 * ones) & (0xf0 * ones);
+
+            return (high | carry >> 4) == 0x33 * ones;
+        }
+
+        // 8个十进制数字的值, 相邻的数字两两合并为2位, 4位, 8位
+        static std::uint64_t eight_digits_value(std::uint64_t word) noexcept
+        {
+            word -= '0' * ones;
+            word  = word * 10 + (word >> 8);
+            word  = (((word & 0x000000ff000000ffull) * (100 + (1000000ull << 32)))
+                    + (((word >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32))))
+                 >> 32;
+
+            return word;
+        }
+
+        // 去掉多余的前导0, 至少保留一个字符
+        static std::string_view trim_zeros(std::string_view text) noexcept
+        {
+            std::size_t zeros = 0;
+            while (zeros + 1 < text.size() and text[zeros] == '0') {
+                zeros++;
+            }
+
+            return text.substr(zeros);
+        }
+
+        static std::string_view remove_prefix(std::string_view text, char lower) noexcept
+        {
+            if (text.size() > 2 and text[0] == '0' and (text[1] | 0x20) == lower) {
+                text.remove_prefix(2);
+            }
+
+            return text;
+        }
+
+        // 数字过多时先检查是否有非法字符, 使两种错误的区分与位数无关
+        template<typename F>
+        static std::errc too_long(std::string_view text, F&& is_digit) noexcept
+        {
+            for (char ch : text) {
+                if (not is_digit(static_cast<unsigned char>(ch))) {
+                    return std::errc::invalid_argument;
+                }
+            }
+
+            return std::errc::result_out_of_range;
+        }
+
+       public:
+        // accept format \d+
+        static std::errc parse_dec(std::string_view text, std::uint64_t& value) noexcept
+        {
+            text = trim_zeros(text);
+            if (text.empty()) {
+                return std::errc::invalid_argument;
+            }
+
+            auto is_digit = [](unsigned char ch) {
+                return static_cast<unsigned>(ch - '0') < 10u;
+            };
+            // 2^64 - 1有20位
+            if (text.size() > 20) {
+                return too_long(text, is_digit);
+            }
+
+            const char* p   = text.data();
+            const char* end = p + text.size();
+            std::uint64_t result = 0;
+
+            // 最多16位, 不会溢出
+            if constexpr (swar) {
+                for (; end - p >= 8; p += 8) {
+                    auto word = load(p);
+                    if (not eight_digits(word)) {
+                        return std::errc::invalid_argument;
+                    }
+
+                    result = result * 100000000 + eight_digits_value(word);
+                }
+            }
+
+            for (; p != end; p++) {
+                auto ch = static_cast<unsigned char>(*p);
+                if (not is_digit(ch)) {
+                    return std::errc::invalid_argument;
+                }
+
+                if (__builtin_mul_overflow(result, 10, &result)
+                    or __builtin_add_overflow(result, ch - '0', &result)) {
+                    return std::errc::result_out_of_range;
+                }
+            }
+
+            value = result;
+            return {};
+        }
+
+        // accept format (0x)?[a-fA-F0-9]+
+        static std::errc parse_hex(std::string_view text, std::uint64_t& value) noexcept
+        {
+            text = trim_zeros(remove_prefix(text, 'x'));
+            if (text.empty()) {
+                return std::errc::invalid_argument;
+            }
+
+            auto is_digit = [](unsigned char ch) { return hex_digits[ch] != 0xff; };
+            if (text.size() > 16) {
+                return too_long(text, is_digit);
+            }
+
+            std::uint64_t result = 0;
+            for (char ch : text) {
+                auto digit = hex_digits[static_cast<unsigned char>(ch)];
+                if (digit == 0xff) {
+                    return std::errc::invalid_argument;
+                }
+
+                result = result << 4 | digit;
+            }
+
+            value = result;
+            return {};
+        }
+
+        // accept format (0b)?[01]+
+        static std::errc parse_bin(std::string_view text, std::uint64_t& value) noexcept
+        {
+            text = trim_zeros(remove_prefix(text, 'b'));
+            if (text.empty()) {
+                return std::errc::invalid_argument;
+            }
+
+            auto is_digit = [](unsigned char ch) { return (ch | 1) == '1'; };
+            if (text.size() > 64) {
+                return too_long(text, is_digit);
+            }
+
+            const char* p   = text.data();
+            const char* end = p + text.size();
+            std::uint64_t result = 0;
+
+            // 每个字节减去'0'后为0或1, 乘法把第i个字节的位移到最高字节的第7 - i位
+            if constexpr (swar) {
+                for (; end - p >= 8; p += 8) {
+                    auto word = load(p);
+                    if ((word & (0xfe * ones)) != '0' * ones) {
+                        return std::errc::invalid_argument;
+                    }
+
+                    auto bits = ((word - '0' * ones) * 0x8040201008040201ull) >> 56;
+                    result    = result << 8 | bits;
+                }
+            }
+
+            for (; p != end; p++) {
+                if (not is_digit(static_cast<unsigned char>(*p))) {
+                    return std::errc::invalid_argument;
+                }
+
+                result = result << 1 | static_cast<std::uint64_t>(*p - '0');
+            }
+
+            value = result;
+            return {};
+        }
+
+        // accept format \d+\.\d+
+        static std::errc parse_fp64(std::string_view text, double& value) noexcept
+        {
+            const char* end = text.data() + text.size();
+            double result   = 0;
+            auto [ptr, ec]  = std::from_chars(text.data(), end, result);
+
+            if (ec != std::errc {}) {
+                return ec;
+            }
+
+            if (ptr != end) {
+                return std::errc::invalid_argument;
+            }
+
+            value = result;
+            return {};
+        }
+    };
+
+} // namespace laxer
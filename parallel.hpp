@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "dfa_table.hpp"
+#include "rule.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+namespace laxer {
+
+    // 对单个大输入进行推测式并行词法分析
+    // 输入被切分为若干块, 每块假设其起点恰好是一个token的起点并独立匹配;
+    // 之后按顺序用前一块实际结束的位置校验推测, 只有推测错误时才从实际位置重新匹配,
+    // 直到与推测得到的token边界重新同步
+    class parallel_lexer {
+       public:
+        using id_t = token::id_t;
+
+        // 每个线程至少处理的字节数, 输入过小时减少线程数
+        inline static constexpr std::size_t default_min_chunk_size = 64 * 1024;
+
+       private:
+        // 一次原始匹配, rule_id为token::default_rule表示没有规则能匹配的字节
+        struct match_t
+        {
+            id_t rule_id;
+            std::size_t offset;
+            std::size_t length;
+        };
+
+        struct chunk_t
+        {
+            // 该块负责起始位置在[begin, end)内的token
+            std::size_t begin, end;
+            std::vector<match_t> matches;
+            // 最后一个token结束的位置, 即下一块实际的起点
+            std::size_t next;
+            token_columns columns;
+            std::exception_ptr error;
+        };
+
+        // 匹配offset处的一个token并返回其结束位置
+        static std::size_t match_one(const dfa_table& table, std::string_view input,
+                                     std::size_t offset, std::vector<match_t>& matches)
+        {
+            std::size_t matched_end = offset;
+            auto rule_id            = table.match(input, offset, matched_end);
+
+            // 没有规则能匹配时消耗一个字节或一段错误区间
+            if (rule_id == dfa_table::invalid_state) {
+                rule_id     = token::default_rule;
+                matched_end = table.unmatched_end(input, offset, token::initial_mode);
+            }
+
+            // 跳过规则不需要记录, 只有一个模式时也不需要切换模式
+            id_t mode = token::initial_mode;
+            if (table.skip(rule_id, mode)) {
+                return matched_end;
+            }
+
+            matches.push_back({rule_id, offset, matched_end - offset});
+
+            return matched_end;
+        }
+
+        // 从chunk.begin开始推测式地匹配
+        static void lex_chunk(const dfa_table& table, std::string_view input,
+                              chunk_t& chunk)
+        {
+            std::size_t offset = chunk.begin;
+
+            chunk.matches.reserve(
+                token_columns::estimated_capacity(chunk.end - chunk.begin));
+
+            while (offset < chunk.end) {
+                offset = match_one(table, input, offset, chunk.matches);
+            }
+
+            chunk.next = offset;
+        }
+
+        // 用前一块实际结束的位置start校验推测, 推测错误时重新匹配直到边界重新同步
+        static void stitch(const dfa_table& table, std::string_view input,
+                           chunk_t& chunk, std::size_t start)
+        {
+            if (start == chunk.begin) {
+                return;
+            }
+
+            auto by_offset = [](const match_t& m, std::size_t offset) {
+                return m.offset < offset;
+            };
+
+            auto& matches      = chunk.matches;
+            auto it            = std::lower_bound(matches.begin(), matches.end(), start,
+                                                  by_offset);
+            std::size_t offset = start;
+            std::vector<match_t> relexed;
+
+            // 匹配从同一位置开始后结果必然相同, 因此遇到推测结果中的token起点即可停止
+            while (offset < chunk.end and (it == matches.end() or it->offset != offset)) {
+                offset = match_one(table, input, offset, relexed);
+                it     = std::lower_bound(it, matches.end(), offset, by_offset);
+            }
+
+            // 整块都没有重新同步, 下一块的实际起点由重新匹配的结果决定
+            if (it == matches.end()) {
+                chunk.next = offset;
+            }
+
+            relexed.insert(relexed.end(), it, matches.end());
+            matches = std::move(relexed);
+        }
+
+        // 把校验后的匹配结果交给规则回调, 生成该块的token列
+        static void emit_chunk(const std::vector<rule>& rules, std::string_view input,
+                               chunk_t& chunk)
+        {
+            chunk.columns.reserve(chunk.matches.size());
+
+            for (const auto& [rule_id, offset, length] : chunk.matches) {
+                const rule* matched =
+                    rule_id == token::default_rule ? nullptr : &rules[rule_id];
+
+                chunk.columns.push_match(matched, input.substr(offset, length), offset);
+            }
+        }
+
+        // 只有一个线程时不需要推测, 直接匹配并生成token列
+        static void lex_sequential(const dfa_table& table, const std::vector<rule>& rules,
+                                   std::string_view input, std::size_t offset,
+                                   token_columns& columns)
+        {
+            columns.reserve(token_columns::estimated_capacity(input.size() - offset));
+
+            id_t mode = token::initial_mode;
+
+            while (offset < input.size()) {
+                std::size_t matched_end = offset;
+                const rule* matched     = nullptr;
+
+                auto rule_id = table.match_token(input, offset, matched_end, mode);
+
+                if (offset == input.size()) {
+                    break;
+                }
+
+                if (rule_id == dfa_table::invalid_state) {
+                    matched_end = table.unmatched_end(input, offset, mode);
+                } else {
+                    matched = &rules[rule_id];
+                }
+
+                columns.push_match(matched, input.substr(offset, matched_end - offset),
+                                   offset, mode);
+                offset = matched_end;
+            }
+        }
+
+        // 每块一个线程执行fn, 第一块在调用线程上执行, 任一线程抛出的异常会在汇合后重新抛出
+        template<typename F>
+        static void run(std::vector<chunk_t>& chunks, F&& fn)
+        {
+            auto guarded = [&fn](chunk_t& chunk) {
+                try {
+                    fn(chunk);
+                } catch (...) {
+                    chunk.error = std::current_exception();
+                }
+            };
+
+            {
+                std::vector<std::jthread> workers;
+                workers.reserve(chunks.size() - 1);
+
+                for (std::size_t i = 1; i < chunks.size(); i++) {
+                    workers.emplace_back(guarded, std::ref(chunks[i]));
+                }
+
+                guarded(chunks.front());
+            }
+
+            for (const auto& chunk : chunks) {
+                if (chunk.error) {
+                    std::rethrow_exception(chunk.error);
+                }
+            }
+        }
+
+       public:
+        // 对input中从begin开始的部分进行词法分析, 结果与顺序调用next_tokens相同
+        // 规则回调会在多个线程中同时调用, 必须是可重入的
+        // thread_count为0时使用硬件线程数; 使用多个模式时块的起始模式未知, 只能顺序匹配
+        static token_columns tokenize(const dfa_table& table,
+                                      const std::vector<rule>& rules,
+                                      std::string_view input, std::size_t begin = 0,
+                                      std::size_t thread_count   = 0,
+                                      bool with_values           = false,
+                                      std::size_t min_chunk_size = default_min_chunk_size)
+        {
+            if (thread_count == 0) {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            std::size_t size = input.size() - begin;
+            thread_count =
+                std::clamp<std::size_t>(size / std::max<std::size_t>(min_chunk_size, 1),
+                                        1, thread_count);
+
+            if (table.get_mode_count() > 1) {
+                thread_count = 1;
+            }
+
+            if (thread_count == 1) {
+                token_columns result(with_values);
+                lex_sequential(table, rules, input, begin, result);
+                return result;
+            }
+
+            std::vector<chunk_t> chunks(thread_count);
+            for (std::size_t i = 0; i < thread_count; i++) {
+                chunks[i].begin   = begin + size * i / thread_count;
+                chunks[i].end     = begin + size * (i + 1) / thread_count;
+                chunks[i].columns = token_columns(with_values);
+            }
+
+            run(chunks, [&](chunk_t& chunk) { lex_chunk(table, input, chunk); });
+
+            // 按顺序校验每一块的推测
+            for (std::size_t i = 1; i < chunks.size(); i++) {
+                stitch(table, input, chunks[i], chunks[i - 1].next);
+            }
+
+            run(chunks, [&](chunk_t& chunk) { emit_chunk(rules, input, chunk); });
+
+            std::size_t total = 0;
+            for (const auto& chunk : chunks) {
+                total += chunk.columns.size();
+            }
+
+            token_columns result(with_values);
+            result.reserve(total);
+
+            for (const auto& chunk : chunks) {
+                result.append(chunk.columns);
+            }
+
+            return result;
+        }
+    };
+
+} // namespace laxer
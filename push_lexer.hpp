@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "compiled_lexer.hpp"
+#include "dfa_table.hpp"
+#include "rule.hpp"
+#include "token.hpp"
+
+namespace laxer {
+
+    // 推送式词法分析器, 由调用者把任意切分的数据块依次喂入, 每完成一个token就通过回调交出
+    // 跨越数据块的token只保存已扫描的字节和DFA状态, 新数据到达后从原状态继续匹配, 不会重新扫描
+    class push_lexer {
+       public:
+        using id_t       = token::id_t;
+        // token文本只在回调期间有效
+        using callback_t = std::function<void(const token&)>;
+
+       private:
+        // 共享的编译结果, laxer之后重新编译也不影响本对象
+        std::shared_ptr<const compiled_lexer> compiled;
+        // 缓存compiled中的DFA表和规则表, 避免匹配时经过shared_ptr
+        const dfa_table* table;
+        const std::vector<rule>* rules;
+        callback_t callback;
+
+        // 尚未完成的token已经收到的字节, 为空时表示下一个token还没有开始
+        std::string pending;
+        // 扫描完pending后的DFA状态
+        id_t state;
+        // pending中最后一次到达终态时接受的规则id和token长度
+        id_t matched;
+        std::size_t matched_length;
+        // 下一个token在整个输入中的偏移
+        std::size_t offset;
+        // 当前所处的模式
+        id_t mode;
+
+        void begin_token(void) noexcept
+        {
+            this->state   = this->table->get_start(this->mode);
+            this->matched = dfa_table::invalid_state;
+        }
+
+        // 从pos开始继续扫描input, length为该token在pos之前已经扫描的字节数
+        std::size_t advance(std::string_view input, std::size_t pos, std::size_t length)
+        {
+            std::size_t matched_end = std::string_view::npos;
+            std::size_t stop =
+                this->table->advance(input, pos, this->state, this->matched, matched_end);
+
+            if (matched_end != std::string_view::npos) {
+                this->matched_length = length + matched_end - pos;
+            }
+
+            return stop;
+        }
+
+        // 当前token的长度, 没有规则能匹配时消耗一个字节
+        inline std::size_t get_length(void) const noexcept
+        {
+            return this->matched == dfa_table::invalid_state ? 1 : this->matched_length;
+        }
+
+        void emit(std::string_view text)
+        {
+            auto matched_offset = this->offset;
+            this->offset       += text.size();
+
+            if (this->matched == dfa_table::invalid_state) {
+                this->callback(
+                    token(token::default_rule, token::invalid_id, text, matched_offset));
+                return;
+            }
+
+            // 跳过规则不产生token
+            if (this->table->skip(this->matched, this->mode)) {
+                return;
+            }
+
+            const auto& matched = (*this->rules)[this->matched];
+            token cur_token     = matched.make_token(text, matched_offset);
+
+            const auto& action = matched.get_action();
+            bool kept          = not action or action(cur_token);
+
+            if (cur_token.get_next_mode() != token::keep_mode) {
+                this->mode = cur_token.get_next_mode();
+            }
+
+            if (kept) {
+                this->callback(cur_token);
+            }
+        }
+
+        // 输出pending开头的token, 回退的字节需要从头重新匹配
+        void emit_pending(std::size_t length)
+        {
+            this->emit(std::string_view(this->pending).substr(0, length));
+            this->pending.erase(0, length);
+
+            while (not this->pending.empty()) {
+                this->begin_token();
+
+                if (this->advance(this->pending, 0, 0) == this->pending.size()) {
+                    return;
+                }
+
+                length = this->get_length();
+                this->emit(std::string_view(this->pending).substr(0, length));
+                this->pending.erase(0, length);
+            }
+        }
+
+        // 在新数据上继续匹配跨越数据块的token, 返回消耗到的位置
+        std::size_t resume(std::string_view input, std::size_t pos)
+        {
+            std::size_t stop = this->advance(input, pos, this->pending.size());
+
+            if (stop == input.size()) {
+                this->pending.append(input.substr(pos));
+                return stop;
+            }
+
+            std::size_t length = this->get_length();
+
+            // token在新数据中结束, 把属于它的部分接到pending后一起输出
+            if (length > this->pending.size()) {
+                std::size_t consumed = length - this->pending.size();
+
+                this->pending.append(input.substr(pos, consumed));
+                this->emit(this->pending);
+                this->pending.clear();
+
+                return pos + consumed;
+            }
+
+            // token在pending中结束, 新数据还没有被消耗
+            this->emit_pending(length);
+
+            return pos;
+        }
+
+        // 匹配完全位于本块内的token, 文本直接引用输入, 返回消耗到的位置
+        std::size_t lex_direct(std::string_view input, std::size_t pos)
+        {
+            this->begin_token();
+
+            if (this->advance(input, pos, 0) == input.size()) {
+                this->pending.assign(input.substr(pos));
+                return input.size();
+            }
+
+            std::size_t length = this->get_length();
+
+            // 之后还可能有数据, 错误区间只合并到本块内下一个能开始匹配的字节
+            if (this->matched == dfa_table::invalid_state) {
+                length = this->table->unmatched_end(input, pos, this->mode, false) - pos;
+            }
+
+            this->emit(input.substr(pos, length));
+
+            return pos + length;
+        }
+
+       public:
+        push_lexer(std::shared_ptr<const compiled_lexer> compiled, callback_t callback)
+            : compiled(std::move(compiled)),
+              table(&this->compiled->get_table()),
+              rules(&this->compiled->get_rules()),
+              callback(std::move(callback)),
+              pending {},
+              state(this->table->get_start()),
+              matched(dfa_table::invalid_state),
+              matched_length(0),
+              offset(0),
+              mode(token::initial_mode)
+        {
+        }
+
+        // 喂入下一块数据, 完成的token在返回前通过回调交出
+        void feed(std::span<const char> data)
+        {
+            std::string_view input(data.data(), data.size());
+            std::size_t pos = 0;
+
+            while (not this->pending.empty() and pos < input.size()) {
+                pos = this->resume(input, pos);
+            }
+
+            while (pos < input.size()) {
+                pos = this->lex_direct(input, pos);
+            }
+        }
+
+        // 输入结束, 输出剩余的token和EOF, 之后可以开始新的输入
+        void finish(void)
+        {
+            while (not this->pending.empty()) {
+                this->emit_pending(this->get_length());
+            }
+
+            this->callback(token(token::eof_rule, token::invalid_id, {}, this->offset));
+
+            this->offset = 0;
+            this->mode   = token::initial_mode;
+            this->begin_token();
+        }
+
+        inline id_t get_mode(void) const noexcept
+        {
+            return this->mode;
+        }
+
+        // 已经输出的token在整个输入中结束的位置
+        inline std::size_t get_offset(void) const noexcept
+        {
+            return this->offset;
+        }
+
+        // 尚未完成的token已经缓存的字节数
+        inline std::size_t get_pending_size(void) const noexcept
+        {
+            return this->pending.size();
+        }
+    };
+
+} // namespace laxer
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "regex_typedef.hpp"
+#include "token.hpp"
+
+namespace laxer {
+
+    // 规则的元数据, 创建后不再修改, 由token中的规则id索引
+    class rule {
+       public:
+        using id_t     = token::id_t;
+        using action_t = token::action_t;
+
+       private:
+        id_t rule_id;
+        id_t token_id;
+        std::string name;
+        action_t action;
+        // 匹配后切换到的模式, token::keep_mode表示不切换
+        id_t next_mode;
+        // 跳过规则匹配的字节直接被消耗, 不产生token也不调用回调
+        bool skip;
+
+       public:
+        rule(id_t rule_id, id_t token_id, std::string name = {}, action_t action = {},
+             id_t next_mode = token::keep_mode, bool skip = false)
+            : rule_id(rule_id),
+              token_id(token_id),
+              name(std::move(name)),
+              action(std::move(action)),
+              next_mode(next_mode),
+              skip(skip)
+        {
+            // 自动生成规则名
+            if (this->name.empty()) {
+                this->name = std::format("rule_{}", token_id);
+            }
+        }
+
+        inline id_t get_rule_id(void) const noexcept
+        {
+            return this->rule_id;
+        }
+
+        inline id_t get_token_id(void) const noexcept
+        {
+            return this->token_id;
+        }
+
+        inline const std::string& get_name(void) const noexcept
+        {
+            return this->name;
+        }
+
+        inline const action_t& get_action(void) const noexcept
+        {
+            return this->action;
+        }
+
+        inline id_t get_next_mode(void) const noexcept
+        {
+            return this->next_mode;
+        }
+
+        inline bool is_skip(void) const noexcept
+        {
+            return this->skip;
+        }
+
+        // 构造该规则匹配得到的token, 尚未调用回调
+        inline token make_token(std::string_view text, std::size_t offset) const noexcept
+        {
+            token cur_token(this->rule_id, this->token_id, text, offset);
+            cur_token.set_next_mode(this->next_mode);
+
+            return cur_token;
+        }
+    };
+
+} // namespace laxer
@@ -0,0 +1,415 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LAXER_SHUFFLE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#include "accelerator.hpp"
+#include "nfa.hpp"
+
+namespace laxer {
+
+    // 状态数小于16的DFA, 用字节重排指令(pshufb)同时模拟从所有状态出发的转换
+    // 每个字节对应一个16字节的转换向量, 第i项为状态i在该字节上的下一个状态,
+    // 对状态向量执行一次重排即可让16个状态各走一步, 依赖链上只有一条单周期指令;
+    // 从所有状态出发走完一段输入得到该段输入上的状态映射, 映射可以按顺序复合,
+    // 因此一段长输入可以切分后在多个线程上分别计算, 不需要推测起始状态
+    class shuffle_dfa {
+       public:
+        using id_t = nfa::dfa::id_t;
+        // 状态映射: map[i]为从内部状态i出发后到达的内部状态
+        using map_t = std::array<std::uint8_t, 16>;
+
+        inline static constexpr id_t invalid_state = std::numeric_limits<id_t>::max();
+        inline static constexpr std::size_t alphabet_size =
+            std::numeric_limits<unsigned char>::max() + 1;
+        // 包括死状态在内的最大状态数
+        inline static constexpr std::size_t max_states = 16;
+        // 每个线程至少处理的字节数
+        inline static constexpr std::size_t default_min_chunk_size = 64 * 1024;
+
+       private:
+        // 内部状态为原状态加1, 0为无效转换到达的死状态, 死状态在任何字节上都转换到自身
+        inline static constexpr std::uint8_t dead_state = 0;
+        // 有加速器的状态在自环字节上的转换带有这个标记, 重排指令只使用低4位, 不受影响
+        inline static constexpr std::uint8_t loop_tag   = 0x10;
+        inline static constexpr std::uint8_t state_mask = 0x0f;
+
+        // transitions[byte][内部状态]
+        alignas(16) std::array<map_t, alphabet_size> transitions;
+        // 各内部状态接受的规则id, 非终态为invalid_state
+        std::array<id_t, max_states> accepts;
+        // 终态的位图, 带标记的状态同样置位
+        std::uint32_t accepting;
+        // 各内部状态的加速器
+        std::array<accelerator, max_states> accelerators;
+        std::size_t state_count;
+        std::uint8_t start;
+        // 当前CPU是否支持SSSE3
+        bool simd;
+
+        static inline std::uint8_t to_inner(id_t state) noexcept
+        {
+            return state == invalid_state ? dead_state
+                                          : static_cast<std::uint8_t>(state + 1);
+        }
+
+        static inline id_t to_outer(std::uint8_t state) noexcept
+        {
+            state &= state_mask;
+
+            return state == dead_state ? invalid_state : static_cast<id_t>(state - 1);
+        }
+
+        static bool detect_simd(void) noexcept
+        {
+#if defined(LAXER_SHUFFLE_SSSE3)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("ssse3");
+#else
+            return false;
+#endif
+        }
+
+        void compose_scalar(const char* p, const char* end, map_t& map) const noexcept
+        {
+            for (; p != end; p++) {
+                const auto& column = this->transitions[static_cast<unsigned char>(*p)];
+
+                for (auto& state : map) {
+                    state = column[state] & state_mask;
+                }
+            }
+        }
+
+        // 单个状态的最长匹配, 返回停止的位置
+        const char* advance_scalar(const char* p, const char* end, std::uint8_t& state,
+                                   std::uint8_t& matched,
+                                   const char*& matched_end) const noexcept
+        {
+            std::uint8_t current  = state;
+            std::uint8_t previous = state;
+
+            while (p != end) {
+                auto next = this->transitions[static_cast<unsigned char>(*p)][current];
+
+                if (next == dead_state) {
+                    break;
+                }
+
+                current = next & state_mask;
+                p++;
+
+                // 在有加速器的状态上连续第二次自环时, 直接跳到第一个离开该状态的字节
+                if (next & previous & loop_tag) [[unlikely]] {
+                    p = this->accelerators[current].skip(p, end);
+                }
+
+                previous = next;
+
+                if ((this->accepting >> current) & 1) {
+                    matched     = current;
+                    matched_end = p;
+                }
+            }
+
+            state = current;
+
+            return p;
+        }
+
+#if defined(LAXER_SHUFFLE_SSSE3)
+        inline const __m128i* vectors(void) const noexcept
+        {
+            return reinterpret_cast<const __m128i*>(this->transitions.data());
+        }
+
+        __attribute__((target("ssse3"))) void compose_ssse3(
+            const char* p, const char* end, map_t& map) const noexcept
+        {
+            const __m128i* table = this->vectors();
+            __m128i states = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&map));
+
+            for (; p != end; p++) {
+                states = _mm_shuffle_epi8(
+                    _mm_load_si128(table + static_cast<unsigned char>(*p)), states);
+            }
+
+            states = _mm_and_si128(states, _mm_set1_epi8(state_mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&map), states);
+        }
+
+        // 状态广播到所有通道, 只读取第0个通道; 读取和判断都不在依赖链上
+        __attribute__((target("ssse3"))) const char* advance_ssse3(
+            const char* p, const char* end, std::uint8_t& state, std::uint8_t& matched,
+            const char*& matched_end) const noexcept
+        {
+            const __m128i* table    = this->vectors();
+            std::uint32_t accepting = this->accepting;
+            __m128i current         = _mm_set1_epi8(static_cast<char>(state));
+            std::uint8_t previous   = state;
+
+            while (p != end) {
+                __m128i next = _mm_shuffle_epi8(
+                    _mm_load_si128(table + static_cast<unsigned char>(*p)), current);
+                auto inner = static_cast<std::uint8_t>(_mm_cvtsi128_si32(next));
+
+                if (inner == dead_state) {
+                    break;
+                }
+
+                current = next;
+                p++;
+
+                // 连续第二次自环时才启动加速器, 与dfa_table::advance相同
+                if (inner & previous & loop_tag) [[unlikely]] {
+                    p = this->accelerators[inner & state_mask].skip(p, end);
+                }
+
+                previous = inner;
+
+                if ((accepting >> inner) & 1) {
+                    matched     = inner;
+                    matched_end = p;
+                }
+            }
+
+            state = static_cast<std::uint8_t>(_mm_cvtsi128_si32(current));
+
+            return p;
+        }
+#endif
+
+       public:
+        // 使用next(state, byte)和accept(state)描述的DFA, 无效转换和非终态为invalid_state
+        template<typename next_t, typename accept_t>
+        shuffle_dfa(std::size_t state_count, id_t start, next_t&& next, accept_t&& accept)
+            : transitions {},
+              accepts {},
+              accepting(0),
+              accelerators {},
+              state_count(state_count),
+              start(to_inner(start)),
+              simd(detect_simd())
+        {
+            if (not fits(state_count)) {
+                throw std::length_error("too many states for a shuffle dfa");
+            }
+
+            this->accepts.fill(invalid_state);
+
+            for (std::size_t state = 0; state < state_count; state++) {
+                auto inner = to_inner(static_cast<id_t>(state));
+
+                for (std::size_t ch = 0; ch < alphabet_size; ch++) {
+                    this->transitions[ch][inner] =
+                        to_inner(next(static_cast<id_t>(state), ch));
+                }
+
+                this->accepts[inner] = accept(static_cast<id_t>(state));
+                if (this->accepts[inner] != invalid_state) {
+                    this->accepting |= (1u << inner) | (1u << (inner | loop_tag));
+                }
+            }
+        }
+
+        explicit shuffle_dfa(const nfa::dfa& dfa)
+            : shuffle_dfa(
+                  dfa.get_state_count(), dfa.get_start(),
+                  [&dfa](id_t state, std::size_t ch) {
+                      return dfa.get_state(state).get_transition(static_cast<char>(ch));
+                  },
+                  [&dfa](id_t state) {
+                      auto it = dfa.get_final().find(state);
+                      return it == dfa.get_final().end() ? invalid_state
+                                                         : it->get_rule_id();
+                  })
+        {
+        }
+
+        // 状态数为state_count的DFA能否使用, 需要为死状态留出一个位置
+        static inline bool fits(std::size_t state_count) noexcept
+        {
+            return state_count < max_states;
+        }
+
+        inline std::size_t get_state_count(void) const noexcept
+        {
+            return this->state_count;
+        }
+
+        inline id_t get_start(void) const noexcept
+        {
+            return to_outer(this->start);
+        }
+
+        inline bool is_simd(void) const noexcept
+        {
+            return this->simd;
+        }
+
+        // 关闭SIMD, 用于测试和比较
+        inline void set_simd(bool enabled) noexcept
+        {
+            this->simd = enabled and detect_simd();
+        }
+
+        // advance在state上自环时用acc跳过其余的自环字节, 不影响compose和run
+        void set_accelerator(id_t state, const accelerator& acc) noexcept
+        {
+            auto inner = to_inner(state);
+
+            this->accelerators[inner] = acc;
+            for (auto& column : this->transitions) {
+                if (column[inner] == inner) {
+                    column[inner] |= loop_tag;
+                }
+            }
+        }
+
+        // 状态接受的规则id, 非终态返回invalid_state
+        inline id_t get_accept(id_t state) const noexcept
+        {
+            return state == invalid_state ? invalid_state
+                                          : this->accepts[to_inner(state)];
+        }
+
+        static inline map_t identity(void) noexcept
+        {
+            map_t map;
+            for (std::size_t i = 0; i < max_states; i++) {
+                map[i] = static_cast<std::uint8_t>(i);
+            }
+
+            return map;
+        }
+
+        // 先经过first再经过second的映射
+        static inline map_t then(const map_t& first, const map_t& second) noexcept
+        {
+            map_t map;
+            for (std::size_t i = 0; i < max_states; i++) {
+                map[i] = second[first[i]];
+            }
+
+            return map;
+        }
+
+        // 从所有状态同时出发走完input, 结果接在map之后
+        map_t compose(std::string_view input, map_t map = identity()) const noexcept
+        {
+            const char* p   = input.data();
+            const char* end = p + input.size();
+
+#if defined(LAXER_SHUFFLE_SSSE3)
+            if (this->simd) {
+                this->compose_ssse3(p, end, map);
+                return map;
+            }
+#endif
+            this->compose_scalar(p, end, map);
+
+            return map;
+        }
+
+        // 映射中从state出发到达的状态, 中途遇到无效转换时为invalid_state
+        static inline id_t apply(const map_t& map, id_t state) noexcept
+        {
+            return to_outer(map[to_inner(state)]);
+        }
+
+        // 从state出发走完input后的状态, 中途遇到无效转换时返回invalid_state
+        // 输入被切分为thread_count块, 各线程分别计算映射后按顺序复合;
+        // thread_count为0时使用硬件线程数
+        id_t run(std::string_view input, id_t state, std::size_t thread_count = 1,
+                 std::size_t min_chunk_size = default_min_chunk_size) const
+        {
+            if (thread_count == 0) {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            thread_count = std::clamp<std::size_t>(
+                input.size() / std::max<std::size_t>(min_chunk_size, 1), 1, thread_count);
+
+            if (thread_count == 1) {
+                return apply(this->compose(input), state);
+            }
+
+            std::vector<map_t> maps(thread_count);
+            auto chunk = [&](std::size_t i) {
+                return input.substr(input.size() * i / thread_count,
+                                    input.size() * (i + 1) / thread_count
+                                        - input.size() * i / thread_count);
+            };
+
+            {
+                std::vector<std::jthread> workers;
+                workers.reserve(thread_count - 1);
+
+                for (std::size_t i = 1; i < thread_count; i++) {
+                    workers.emplace_back(
+                        [&, i]() noexcept { maps[i] = this->compose(chunk(i)); });
+                }
+
+                maps.front() = this->compose(chunk(0));
+            }
+
+            map_t map = maps.front();
+            for (std::size_t i = 1; i < thread_count; i++) {
+                map = then(map, maps[i]);
+            }
+
+            return apply(map, state);
+        }
+
+        // 整个input能否被匹配, 返回接受的规则id, 不能匹配时返回invalid_state
+        inline id_t match(std::string_view input, std::size_t thread_count = 1) const
+        {
+            return this->get_accept(this->run(input, this->get_start(), thread_count));
+        }
+
+        // 与dfa_table::advance相同: 从state开始扫描offset之后的部分直到遇到无效转换,
+        // 返回停止的位置, state更新为停止前的状态, 经过终态时更新matched与matched_end;
+        // 在有加速器的状态上自环时由加速器跳过其余的自环字节
+        std::size_t advance(std::string_view input, std::size_t offset, id_t& state,
+                            id_t& matched, std::size_t& matched_end) const noexcept
+        {
+            const char* begin        = input.data();
+            const char* end          = begin + input.size();
+            const char* last_end     = nullptr;
+            std::uint8_t inner       = to_inner(state);
+            std::uint8_t last_accept = dead_state;
+            const char* p            = begin + offset;
+
+#if defined(LAXER_SHUFFLE_SSSE3)
+            if (this->simd) {
+                p = this->advance_ssse3(p, end, inner, last_accept, last_end);
+            }
+#endif
+            if (not this->simd) {
+                p = this->advance_scalar(p, end, inner, last_accept, last_end);
+            }
+
+            if (last_end != nullptr) {
+                matched     = this->accepts[last_accept & state_mask];
+                matched_end = static_cast<std::size_t>(last_end - begin);
+            }
+
+            state = to_outer(inner);
+
+            return static_cast<std::size_t>(p - begin);
+        }
+    };
+
+} // namespace laxer
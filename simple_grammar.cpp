@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include "laxer.hpp"
 #include "token.hpp"
+#include "token_buffer.hpp"
 
 enum tokens
 {
@@ -23,9 +24,9 @@ bool debug(laxer::token &token)
     return true;
 }
 
-std::uint64_t parse_number(laxer::laxer &l)
+std::uint64_t parse_number(laxer::token_buffer &buffer)
 {
-    auto token = l.next_token();
+    auto token = buffer.consume();
 
     if (token.get_token_id() != tokens::number) {
         throw std::runtime_error("expect a number");
@@ -34,28 +35,29 @@ std::uint64_t parse_number(laxer::laxer &l)
     return std::get<std::uint64_t>(token.get_token_value());
 }
 
-char parse_op(laxer::laxer &l)
+char parse_op(laxer::token_buffer &buffer)
 {
-    auto token = l.next_token();
+    // 只有运算符才消耗, 其余token留给调用者
+    const auto &token = buffer.peek();
 
     if (tokens::operators != token.get_token_id()) {
         // throw std::runtime_error("expect a operator");
         return 'E';
     }
 
-    return std::get<std::string>(token.get_token_value()).front();
+    return std::get<std::string_view>(buffer.consume().get_token_value()).front();
 }
 
-std::uint64_t parse_exp(laxer::laxer &l)
+std::uint64_t parse_exp(laxer::token_buffer &buffer)
 {
-    auto left = parse_number(l);
-    auto op   = parse_op(l);
+    auto left = parse_number(buffer);
+    auto op   = parse_op(buffer);
 
     if ('E' == op) {
         return left;
     }
 
-    auto right = parse_exp(l);
+    auto right = parse_exp(buffer);
 
     std::uint64_t res = 0;
 
@@ -88,7 +90,8 @@ int main(const int argc, const char **argv)
     l.add_rule("[ \r\n\t]", tokens::space);
     l.add_rule(".", tokens::error, debug, "error token");
 
-    std::cout << std::format("={}", parse_exp(l));
+    laxer::token_buffer buffer(l);
+    std::cout << std::format("={}", parse_exp(buffer));
 
     return 0;
 }
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "regex_typedef.hpp"
+
+namespace laxer {
+
+    // 标识符和关键字的符号表
+    // 相同的文本只保存一份, 映射到从0开始连续的符号id, 后续阶段比较和哈希符号时只需要比较id;
+    // 文本复制到按块分配的内存池中, 不依赖输入缓冲区, 流式输入的窗口移动后仍然有效;
+    // 查找使用线性探测的开放寻址哈希表, 槽位中保存哈希值, 探测和扩容时不需要访问文本
+    // 符号表不加锁, 并行匹配的回调中使用时需要每个线程一张表, 或由调用者同步
+    class symbol_table {
+       public:
+        using id_t = regex::id_t;
+
+        inline static constexpr id_t invalid_id = std::numeric_limits<id_t>::max();
+        // 内存池每块的大小, 更长的文本单独分配一块
+        inline static constexpr std::size_t block_size = 64 * 1024;
+
+       private:
+        // 槽位下标取哈希值的低位, 保存低32位即可在扩容时重新定位
+        struct slot_t
+        {
+            std::uint32_t hash;
+            id_t id;
+        };
+
+        // 槽位数为2的幂, 装载因子不超过1/2
+        inline static constexpr std::size_t initial_slots = 64;
+
+        std::vector<std::unique_ptr<char[]>> blocks;
+        // 当前块中未使用的部分
+        char* free_begin;
+        std::size_t free_size;
+
+        std::vector<std::string_view> symbols;
+        std::vector<slot_t> slots;
+
+        static std::vector<slot_t> empty_slots(void)
+        {
+            return std::vector<slot_t>(initial_slots, slot_t {0, invalid_id});
+        }
+
+        std::size_t mask(void) const noexcept
+        {
+            return this->slots.size() - 1;
+        }
+
+        std::string_view store(std::string_view text)
+        {
+            if (text.empty()) {
+                return {};
+            }
+
+            if (text.size() > this->free_size) {
+                auto size = std::max(text.size(), block_size);
+                this->blocks.push_back(std::make_unique_for_overwrite<char[]>(size));
+
+                this->free_begin = this->blocks.back().get();
+                this->free_size  = size;
+            }
+
+            char* copy = this->free_begin;
+            std::memcpy(copy, text.data(), text.size());
+
+            this->free_begin += text.size();
+            this->free_size  -= text.size();
+
+            return {copy, text.size()};
+        }
+
+        void grow(void)
+        {
+            std::vector<slot_t> old(this->slots.size() * 2, slot_t {0, invalid_id});
+            old.swap(this->slots);
+
+            for (const auto& slot : old) {
+                if (slot.id == invalid_id) {
+                    continue;
+                }
+
+                auto index = slot.hash & this->mask();
+                while (this->slots[index].id != invalid_id) {
+                    index = (index + 1) & this->mask();
+                }
+
+                this->slots[index] = slot;
+            }
+        }
+
+        // 返回文本所在的槽位, 或者探测结束处的空槽位
+        std::size_t probe(std::string_view text, std::uint32_t hash) const noexcept
+        {
+            auto index = hash & this->mask();
+
+            for (;; index = (index + 1) & this->mask()) {
+                const auto& slot = this->slots[index];
+
+                if (slot.id == invalid_id) {
+                    return index;
+                }
+
+                if (slot.hash == hash and this->symbols[slot.id] == text) {
+                    return index;
+                }
+            }
+        }
+
+       public:
+        symbol_table(void)
+            : blocks {},
+              free_begin(nullptr),
+              free_size(0),
+              symbols {},
+              slots(empty_slots())
+        {
+        }
+
+        // 内存池中的文本被符号引用, 移动后仍然有效, 但不能拷贝
+        // 被移动的符号表恢复为初始容量的空表, 可以继续使用
+        symbol_table(const symbol_table&)            = delete;
+        symbol_table& operator=(const symbol_table&) = delete;
+
+        symbol_table(symbol_table&& other)
+            : blocks(std::exchange(other.blocks, {})),
+              free_begin(std::exchange(other.free_begin, nullptr)),
+              free_size(std::exchange(other.free_size, 0)),
+              symbols(std::exchange(other.symbols, {})),
+              slots(std::exchange(other.slots, empty_slots()))
+        {
+        }
+
+        symbol_table& operator=(symbol_table&& other)
+        {
+            if (this != &other) {
+                this->slots      = std::exchange(other.slots, empty_slots());
+                this->blocks     = std::exchange(other.blocks, {});
+                this->free_begin = std::exchange(other.free_begin, nullptr);
+                this->free_size  = std::exchange(other.free_size, 0);
+                this->symbols    = std::exchange(other.symbols, {});
+            }
+
+            return *this;
+        }
+
+        // 每次读取8个字节混合, 最后不足8个字节的部分补0
+        static std::uint64_t hash(std::string_view text) noexcept
+        {
+            const char* p = text.data();
+            std::size_t n = text.size();
+            std::uint64_t h = 0x9e3779b97f4a7c15ull ^ (n * 0xff51afd7ed558ccdull);
+
+            auto mix = [&h](std::uint64_t word) {
+                h ^= word;
+                h *= 0xbf58476d1ce4e5b9ull;
+                h ^= h >> 29;
+            };
+
+            for (; n >= 8; p += 8, n -= 8) {
+                std::uint64_t word;
+                std::memcpy(&word, p, 8);
+                mix(word);
+            }
+
+            if (n > 0) {
+                std::uint64_t word = 0;
+                std::memcpy(&word, p, n);
+                mix(word);
+            }
+
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+
+            return h;
+        }
+
+        // 返回文本的符号id, 第一次出现时分配新的id
+        id_t intern(std::string_view text)
+        {
+            auto h     = static_cast<std::uint32_t>(hash(text));
+            auto index = this->probe(text, h);
+
+            if (this->slots[index].id != invalid_id) {
+                return this->slots[index].id;
+            }
+
+            auto id = static_cast<id_t>(this->symbols.size());
+            this->symbols.push_back(this->store(text));
+            this->slots[index] = {h, id};
+
+            if (this->symbols.size() * 2 > this->slots.size()) {
+                this->grow();
+            }
+
+            return id;
+        }
+
+        // 只查找不插入, 不存在时返回invalid_id
+        id_t find(std::string_view text) const noexcept
+        {
+            auto h = static_cast<std::uint32_t>(hash(text));
+            return this->slots[this->probe(text, h)].id;
+        }
+
+        std::string_view get_text(id_t id) const noexcept
+        {
+            return this->symbols[id];
+        }
+
+        std::string_view operator[](id_t id) const noexcept
+        {
+            return this->symbols[id];
+        }
+
+        std::size_t size(void) const noexcept
+        {
+            return this->symbols.size();
+        }
+
+        bool empty(void) const noexcept
+        {
+            return this->symbols.empty();
+        }
+
+        // 预留符号数, 避免分析过程中扩容
+        void reserve(std::size_t count)
+        {
+            this->symbols.reserve(count);
+            while (count * 2 > this->slots.size()) {
+                this->grow();
+            }
+        }
+    };
+
+} // namespace laxer
@@ -0,0 +1,165 @@
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "accelerator.hpp"
+#include "dfa_table.hpp"
+#include "fuzz_input.hpp"
+#include "laxer.hpp"
+#include "token.hpp"
+
+using laxer::dfa_table;
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\"[^\"]*\"", 0, {}, "strings");
+    l.add_rule("//[^\n]*", 1, {}, "comments");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 2, {}, "identifiers");
+    l.add_rule("\\d+", 3, {}, "numbers");
+    // 包含哨兵字节的规则
+    l.add_rule(std::string("<\0>", 3), 4, {}, "nul");
+    l.add_skip_rule("[ \t\r\n]+", "spaces");
+}
+
+// 不使用加速器, 逐字节查表的最长匹配
+dfa_table::id_t reference_match(const dfa_table& table, std::string_view input,
+                                std::size_t offset, std::size_t& matched_end)
+{
+    auto state   = table.get_start();
+    auto matched = dfa_table::invalid_state;
+
+    for (std::size_t i = offset; i < input.size(); i++) {
+        auto next = table.next(state, input[i]);
+        if (next == dfa_table::invalid_state and input[i] == dfa_table::sentinel) {
+            next = table.next_sentinel(state);
+        }
+
+        if (next == dfa_table::invalid_state) {
+            break;
+        }
+
+        state = next;
+        if (table.get_accept(state) != dfa_table::invalid_state) {
+            matched     = table.get_accept(state);
+            matched_end = i + 1;
+        }
+    }
+
+    return matched;
+}
+
+bool same_matches(const dfa_table& table, std::string_view input)
+{
+    for (std::size_t offset = 0; offset < input.size(); offset++) {
+        std::size_t end = offset, expected_end = offset;
+
+        if (table.match(input, offset, end)
+                != reference_match(table, input, offset, expected_end)
+            or end != expected_end) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(const int argc, const char** argv)
+{
+    laxer_test::fuzz_input fuzz({"\"" + std::string(40, 'x') + "\"", "\"short\"", "\"open",
+                                 "// comment\n", "long_identifier_with_digits_0123456789",
+                                 "42", std::string(50, ' '), "\n\t", std::string("<\0>", 3),
+                                 std::string("\"a\0b\"", 5), "#"});
+
+    // 区间的划分和跳过的位置
+    std::bitset<laxer::accelerator::alphabet_size> stays;
+    for (char ch : std::string_view("\t\n\r ")) {
+        stays[static_cast<unsigned char>(ch)] = true;
+    }
+
+    laxer::accelerator spaces(stays);
+    assert(spaces.get_range_count() == 3);
+
+    std::string text(100, ' ');
+    for (std::size_t stop = 0; stop < text.size(); stop++) {
+        text[stop] = 'x';
+        for (std::size_t begin = 0; begin <= stop; begin += 7) {
+            assert(spaces.skip(text.data() + begin, text.data() + text.size())
+                   == text.data() + stop);
+        }
+        text[stop] = "\t\n\r "[fuzz.below(4)];
+    }
+    assert(spaces.skip(text.data(), text.data() + text.size())
+           == text.data() + text.size());
+
+    stays.reset();
+    for (char ch : std::string_view("acegik")) {
+        stays[static_cast<unsigned char>(ch)] = true;
+    }
+    assert(laxer::accelerator(stays).empty());
+
+    stays.reset();
+    assert(laxer::accelerator(stays).empty());
+
+    laxer::laxer l;
+    setup_rules(l);
+    l.generate_dfa();
+
+    // 状态很少, 使用字节重排的内层循环; 去掉后使用逐字节查表的内层循环
+    const auto& shuffled = l.get_table();
+    assert(shuffled.has_shuffle());
+
+    dfa_table plain = shuffled;
+    plain.clear_shuffle();
+
+    std::size_t accelerated = 0;
+    for (std::size_t state = 0; state < plain.get_state_count(); state++) {
+        auto id      = static_cast<dfa_table::id_t>(state);
+        accelerated += plain.get_accelerator(id) != nullptr;
+    }
+    assert(accelerated >= 4);
+
+    std::string input;
+    for (int round = 0; round < 50; round++) {
+        input = fuzz.next(40);
+
+        assert(same_matches(shuffled, input));
+        assert(same_matches(plain, input));
+    }
+
+    // 流输入的窗口上跳过自环的字节, token跨越块边界
+    input.clear();
+    for (const auto& piece : fuzz.get_pieces()) {
+        input += piece + " ";
+    }
+
+    std::vector<std::string> expected;
+    l.reset(input);
+    for (auto token = l.next_token(); not token.is_eof(); token = l.next_token()) {
+        expected.emplace_back(token.get_matched_text());
+    }
+
+    for (std::size_t chunk_size : {1, 5, 64}) {
+        std::stringbuf sb(input);
+        laxer::laxer stream(&sb, chunk_size);
+        setup_rules(stream);
+
+        std::size_t i = 0;
+        for (auto token = stream.next_token(); not token.is_eof();
+             token      = stream.next_token(), i++) {
+            assert(i < expected.size() and token.get_matched_text() == expected[i]);
+        }
+        assert(i == expected.size());
+    }
+
+    std::cout << std::format("{} of {} states accelerated, {} tokens\n", accelerated,
+                             plain.get_state_count(), expected.size());
+    std::cout << "accelerator test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <cassert>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+#include "laxer.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("0x[a-fA-F0-9]+", 1, laxer::converter::hex, "hex numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 2, {}, "identifiers");
+    l.add_rule("[ \r\n\t]+", 3, laxer::converter::ignore, "ignores");
+}
+
+int main(const int argc, const char** argv)
+{
+    const std::string input = "foo 12 0x1f bar_1 ? 7\n";
+
+    laxer::laxer reference(input);
+    setup_rules(reference);
+
+    laxer::laxer l(input);
+    setup_rules(l);
+
+    auto columns = l.tokenize_all(true);
+
+    std::size_t index = 0;
+    for (auto token = reference.next_token(); not token.is_eof();
+         token = reference.next_token(), index++) {
+        assert(index < columns.size());
+        assert(columns.get_ids()[index] == token.get_token_id());
+        assert(columns.get_offsets()[index] == token.get_offset());
+        assert(columns.get_lengths()[index] == token.get_length());
+        assert(columns.get_text(index, input) == token.get_matched_text());
+        assert(columns.get_values()[index] == token.get_token_value());
+    }
+    assert(index == columns.size());
+    assert(std::get<std::uint64_t>(columns.get_values()[2]) == 0x1f);
+
+    // 分批读取流输入, 不记录值列
+    std::stringbuf sb(input);
+    laxer::laxer stream(&sb, 4);
+    setup_rules(stream);
+
+    laxer::token_columns batches;
+    while (stream.next_tokens(batches, 2) != 0) {
+        std::cout << std::format("{} tokens\n", batches.size());
+    }
+
+    assert(batches.get_ids().size() == columns.size());
+    assert(batches.get_values().empty());
+    for (std::size_t i = 0; i < batches.size(); i++) {
+        assert(batches.get_ids()[i] == columns.get_ids()[i]);
+        assert(batches.get_offsets()[i] == columns.get_offsets()[i]);
+        assert(batches.get_lengths()[i] == columns.get_lengths()[i]);
+    }
+
+    // 流输入的字符串值拷贝到值列中, 窗口移动后仍然有效
+    std::stringbuf strings_sb(input);
+    laxer::laxer strings(&strings_sb, 4);
+    strings.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 2, laxer::converter::string,
+                     "identifiers");
+    strings.add_rule("[ \n0-9?]", 3, laxer::converter::ignore, "others");
+
+    auto copied = strings.tokenize_all(true);
+    assert(copied.size() == 3);
+    for (std::size_t i = 0; i < copied.size(); i++) {
+        assert(std::get<std::string_view>(copied.get_values()[i])
+               == copied.get_text(i, input));
+    }
+
+    // 输入比生成列的输入短时, 越界的token文本为空
+    const auto last = copied.size() - 1;
+    assert(copied.in_range(last, input));
+    assert(not copied.in_range(last, std::string_view(input).substr(0, 1)));
+    assert(copied.get_text(last, std::string_view(input).substr(0, 1)).empty());
+
+    // 长度列放不下的token不会被截断, 已有的列保持一致
+    bool thrown = false;
+    try {
+        batches.push_back(0, 0, std::size_t {1} << 32);
+    } catch (const std::length_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(batches.get_ids().size() == batches.get_lengths().size());
+
+    return 0;
+}
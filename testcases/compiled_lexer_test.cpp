@@ -0,0 +1,112 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compiled_lexer.hpp"
+#include "laxer.hpp"
+#include "lexer_cursor.hpp"
+#include "same_columns.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+int main(const int argc, const char** argv)
+{
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 8; i++) {
+        std::string input;
+        for (int j = 0; j < 500; j++) {
+            input += std::format("var_{} = {} + 0x{:x} ;\n", i * j, j, i + j);
+        }
+        inputs.push_back(std::move(input));
+    }
+
+    std::vector<laxer::token_columns> expected;
+    std::shared_ptr<const laxer::compiled_lexer> compiled;
+
+    {
+        laxer::laxer l;
+        l.add_rule("0x[0-9a-fA-F]+", 0, {}, "hex");
+        l.add_rule("\\d+", 1, {}, "dec");
+        l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 2, {}, "identifiers");
+        l.add_rule("[=+;]", 3, {}, "operators");
+        l.add_skip_rule("[ \r\n\t]+", "spaces");
+
+        for (const auto& input : inputs) {
+            l.reset(input);
+            expected.push_back(l.tokenize_all());
+        }
+
+        compiled = l.share();
+        assert(compiled == l.share());
+
+        // 之后修改laxer不影响已经取出的编译结果
+        l.set_error_runs(true);
+        assert(compiled != l.get_compiled());
+        assert(not compiled->get_table().get_error_runs());
+    }
+
+    // laxer销毁后编译结果仍然有效, 多个线程各自使用游标
+    std::vector<laxer::token_columns> results(inputs.size());
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t i = 0; i < inputs.size(); i++) {
+            threads.emplace_back([&, i] {
+                laxer::lexer_cursor cursor(compiled);
+
+                // 同一个游标反复切换输入
+                for (int round = 0; round < 3; round++) {
+                    cursor.reset(inputs[i]);
+                    results[i] = cursor.tokenize_all();
+                }
+            });
+        }
+    }
+
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+        assert(laxer_test::same_columns(results[i], expected[i]));
+    }
+
+    // 流输入游标与并行匹配
+    std::stringbuf buffer(inputs[3]);
+    laxer::lexer_cursor streamed(compiled, &buffer, 64);
+    assert(streamed.is_streaming());
+    assert(laxer_test::same_columns(streamed.tokenize_all(), expected[3]));
+
+    laxer::lexer_cursor cursor(compiled, inputs[5]);
+    assert(laxer_test::same_columns(cursor.tokenize_parallel(4), expected[5]));
+
+    cursor.reset(inputs[0]);
+    auto token = cursor.next_token();
+    assert(compiled->get_rule_name(token) == "identifiers");
+    assert(compiled->get_mode_name(laxer::token::initial_mode) == "INITIAL");
+
+    bool thrown = false;
+    try {
+        cursor.set_mode(1);
+    } catch (const laxer::lexer_cursor::laxer_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // 没有编译结果的游标
+    thrown = false;
+    try {
+        laxer::lexer_cursor empty(nullptr, inputs[0]);
+        empty.next_token();
+    } catch (const laxer::lexer_cursor::laxer_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << std::format("{} inputs, {} tokens each\n", inputs.size(),
+                             expected[0].size());
+    std::cout << "compiled lexer test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+
+#include "laxer.hpp"
+#include "same_columns.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, {}, "numbers");
+    l.add_rule("abc", 1, {}, "abc");
+    l.add_skip_rule("[ \r\n\t]+", "spaces");
+    l.set_error_runs(true);
+}
+
+int main(const int argc, const char** argv)
+{
+    // "ab"能开始匹配"abc"但最终匹配失败, 同样属于错误区间
+    std::string input = std::string("\x01\x02\0ab\xff", 6) + "abc 123 ##\n";
+
+    laxer::laxer l(input);
+    setup_rules(l);
+
+    auto token = l.next_token();
+    assert(token.is_default());
+    assert(token.get_matched_text() == std::string_view(input).substr(0, 6));
+
+    token = l.next_token();
+    assert(token.get_matched_text() == "abc");
+    token = l.next_token();
+    assert(token.get_matched_text() == "123");
+    token = l.next_token();
+    assert(token.is_default() and token.get_matched_text() == "##");
+    assert(l.next_token().is_eof());
+
+    // 关闭后逐字节返回
+    l.reset(input);
+    l.set_error_runs(false);
+    assert(l.next_token().get_length() == 1);
+    l.set_error_runs(true);
+
+    // 大段随机字节
+    std::mt19937 rng(7);
+    std::string garbage;
+    for (int i = 0; i < 20000; i++) {
+        garbage += static_cast<char>(rng() % 256);
+        if (i % 1000 == 0) {
+            garbage += " 42 abc ";
+        }
+    }
+
+    l.reset(garbage);
+    auto expected = l.tokenize_all();
+
+    std::size_t default_count = 0;
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        if (expected.get_ids()[i] == laxer::token::invalid_id) {
+            default_count++;
+        }
+
+        // 紧挨着的错误区间已经被合并
+        if (i > 0 and expected.get_ids()[i] == laxer::token::invalid_id
+            and expected.get_ids()[i - 1] == laxer::token::invalid_id) {
+            assert(expected.get_offsets()[i - 1] + expected.get_lengths()[i - 1]
+                   != expected.get_offsets()[i]);
+        }
+    }
+    assert(default_count < garbage.size() / 2);
+
+    l.reset(garbage);
+    assert(laxer_test::same_columns(l.tokenize_parallel(4), expected));
+
+    auto parallel = laxer::parallel_lexer::tokenize(l.get_table(), l.get_rules(),
+                                                    garbage, 0, 4, false, 1024);
+    assert(laxer_test::same_columns(parallel, expected));
+
+    // 流输入和推送式输入只在当前数据块内合并, 覆盖的字节与token仍然相同
+    auto covered = [](const laxer::token_columns& columns) {
+        std::size_t bytes = 0;
+        for (auto length : columns.get_lengths()) {
+            bytes += length;
+        }
+        return bytes;
+    };
+
+    std::stringbuf buffer(garbage);
+    laxer::laxer streamed(&buffer, 4096);
+    setup_rules(streamed);
+    auto stream_columns = streamed.tokenize_all();
+    assert(covered(stream_columns) == covered(expected));
+
+    // 增量输入
+    auto incremental = l.make_incremental_lexer();
+    incremental.lex(garbage);
+    assert(laxer_test::same_columns(incremental.get_columns(), expected));
+
+    const std::string alphabet = "ab1 \x01c";
+    for (int round = 0; round < 500; round++) {
+        std::size_t position = rng() % (garbage.size() + 1);
+        std::size_t removed =
+            std::min<std::size_t>(rng() % 3, garbage.size() - position);
+        std::string inserted(1, alphabet[rng() % alphabet.size()]);
+
+        garbage.replace(position, removed, inserted);
+        incremental.apply(garbage, {position, removed, inserted});
+
+        l.reset(garbage);
+        assert(laxer_test::same_columns(incremental.get_columns(), l.tokenize_all()));
+    }
+
+    std::cout << std::format("{} tokens, {} error runs\n", expected.size(),
+                             default_count);
+    std::cout << "error run test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace laxer_test {
+
+    // 随机测试使用的固定种子, 失败时可以复现
+    inline constexpr std::mt19937::result_type fuzz_seed = 0x5eed;
+
+    // 把给定的片段随机拼接成输入, 用于与参考实现逐个token比较
+    // 片段中应包含边界情况: 未闭合的token, 无法匹配的字节和输入中的哨兵字节等
+    class fuzz_input {
+       private:
+        std::mt19937 rng;
+        std::vector<std::string> pieces;
+
+       public:
+        explicit fuzz_input(std::vector<std::string> pieces = {},
+                            std::mt19937::result_type seed = fuzz_seed)
+            : rng(seed), pieces(std::move(pieces))
+        {
+        }
+
+        // [0, bound)之间的随机数
+        std::size_t below(std::size_t bound)
+        {
+            return this->rng() % bound;
+        }
+
+        const std::string& piece(void)
+        {
+            return this->pieces[this->below(this->pieces.size())];
+        }
+
+        // 拼接[0, max_pieces)个随机片段
+        std::string next(std::size_t max_pieces)
+        {
+            std::string input;
+
+            for (std::size_t count = this->below(max_pieces); count > 0; count--) {
+                input += this->piece();
+            }
+
+            return input;
+        }
+
+        const std::vector<std::string>& get_pieces(void) const noexcept
+        {
+            return this->pieces;
+        }
+    };
+
+} // namespace laxer_test
@@ -0,0 +1,117 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "incremental_lexer.hpp"
+#include "laxer.hpp"
+#include "same_columns.hpp"
+#include "token_columns.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    // "12."后面不是数字时需要回退到"12"
+    l.add_rule("\\d+\\.\\d+", 0, {}, "floats");
+    l.add_rule("\\d+", 1, {}, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 2, laxer::converter::string, "identifiers");
+    // 没有闭合的字符串会一直读到输入末尾再回退
+    l.add_rule("\"[^\"]*\"", 3, {}, "strings");
+    l.add_rule("[ \r\n\t]+", 4, laxer::converter::ignore, "ignores");
+}
+
+// 字符串值都指向text中token自己的文本
+bool values_in(const laxer::token_columns& columns, std::string_view text)
+{
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        auto value = std::get_if<std::string_view>(&columns.get_values()[i]);
+
+        if (value and *value != columns.get_text(i, text)) {
+            return false;
+        }
+        if (value and value->data() != text.data() + columns.get_offsets()[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(const int argc, const char** argv)
+{
+    laxer::laxer l;
+    setup_rules(l);
+
+    auto full = [&l](const std::string& text) {
+        l.reset(text);
+        return l.tokenize_all(true);
+    };
+
+    std::string text;
+    for (int i = 0; i < 40; i++) {
+        text += std::format("name_{} = {}.{} + \"str {}\" ;\n", i, i, i * 3, i);
+    }
+
+    auto incremental = l.make_incremental_lexer(true);
+    incremental.lex(text);
+    assert(laxer_test::same_columns(incremental.get_columns(), full(text)));
+
+    // 局部编辑只替换被编辑的标识符
+    std::size_t offset = text.find("name_20");
+    text.insert(offset + 4, "xy");
+    auto change = incremental.apply(text, {offset + 4, 0, "xy"});
+    assert(laxer_test::same_columns(incremental.get_columns(), full(text)));
+    assert(change.removed == 1 and change.inserted == 1);
+
+    // 打开一个字符串会影响到后面所有的token
+    std::mt19937 rng(42);
+    const std::string alphabet = "a1. \"\n_";
+
+    for (int round = 0; round < 300; round++) {
+        std::size_t position = rng() % (text.size() + 1);
+        std::size_t removed  = std::min<std::size_t>(rng() % 4, text.size() - position);
+        std::string inserted;
+
+        for (std::size_t i = rng() % 4; i > 0; i--) {
+            inserted += alphabet[rng() % alphabet.size()];
+        }
+
+        text.replace(position, removed, inserted);
+        incremental.apply(text, {position, removed, inserted});
+
+        assert(laxer_test::same_columns(incremental.get_columns(), full(text)));
+    }
+    assert(values_in(incremental.get_columns(), text));
+
+    // 编辑后的文本放在新的缓冲区中, 旧缓冲区释放后值仍然有效
+    {
+        std::string moved = text;
+        std::size_t end   = moved.size();
+        moved += " tail_name";
+        text.clear();
+        text.shrink_to_fit();
+
+        incremental.apply(moved, {end, 0, " tail_name"});
+        assert(laxer_test::same_columns(incremental.get_columns(), full(moved)));
+        assert(values_in(incremental.get_columns(), moved));
+        text = std::move(moved);
+    }
+
+    std::cout << std::format("{} tokens after edits\n", incremental.get_columns().size());
+
+    // 编辑与文本不一致
+    bool thrown = false;
+    try {
+        incremental.apply(text, {text.size(), 1, ""});
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "incremental lexer test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fuzz_input.hpp"
+#include "laxer.hpp"
+#include "lexer_cursor.hpp"
+#include "same_columns.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    auto string_mode = l.add_mode("STRING");
+
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 1, {}, "identifiers");
+    // 包含哨兵字节的规则
+    l.add_rule(std::string("<\0>", 3), 2, {}, "nul");
+    l.add_rule("[ \t]+", 3, laxer::converter::ignore, "ignores");
+    l.add_skip_rule("\n+", "newlines");
+    l.add_mode_rule({laxer::token::initial_mode}, "\"", 4, {}, "open quote", string_mode);
+    l.add_mode_rule({string_mode}, "[^\"]+", 5, {}, "content");
+    l.add_mode_rule({string_mode}, "\"", 4, {}, "close quote",
+                    laxer::token::initial_mode);
+    l.set_error_runs(true);
+}
+
+int main(const int argc, const char** argv)
+{
+    laxer::laxer l;
+    setup_rules(l);
+    auto compiled = l.share();
+
+    // 长短不一的记录, 其中有空记录, 未闭合的字符串和无法匹配的字节
+    laxer_test::fuzz_input fuzz({"name", "42", " ", "\t", "\n", "\"str ing\"", "\"open",
+                                 "#?", "_x9", "<", ">", std::string("<\0>", 3)});
+
+    std::vector<std::string> records;
+    for (int i = 0; i < 300; i++) {
+        records.push_back(fuzz.next(40));
+    }
+
+    std::vector<std::string_view> inputs(records.begin(), records.end());
+
+    std::vector<laxer::token_columns> expected;
+    for (auto input : inputs) {
+        laxer::lexer_cursor cursor(compiled, input);
+        expected.push_back(cursor.tokenize_all(true));
+    }
+
+    std::size_t total = 0;
+    for (std::size_t lane_count : {1, 3, 4, 16}) {
+        auto results = compiled->tokenize_many(inputs, true, lane_count);
+        assert(results.size() == inputs.size());
+
+        for (std::size_t i = 0; i < inputs.size(); i++) {
+            assert(laxer_test::same_columns(results[i], expected[i]));
+        }
+
+        total = 0;
+        for (const auto& columns : results) {
+            total += columns.size();
+        }
+    }
+
+    // 记录比通道少
+    auto few = compiled->tokenize_many(std::span(inputs).first(2), false, 16);
+    assert(few.size() == 2 and few[1].size() == expected[1].size());
+    assert(compiled->tokenize_many({}).empty());
+
+    std::cout << std::format("{} records, {} tokens\n", inputs.size(), total);
+    std::cout << "interleaved test passed\n";
+
+    return 0;
+}
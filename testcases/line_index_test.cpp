@@ -0,0 +1,100 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "fuzz_input.hpp"
+#include "laxer.hpp"
+#include "line_index.hpp"
+#include "token.hpp"
+
+// 从头逐字节计算行号和列号
+laxer::line_index::position_t rescan(std::string_view text, std::size_t offset)
+{
+    laxer::line_index::position_t position {1, 1};
+
+    for (std::size_t i = 0; i < offset; i++) {
+        if (text[i] == '\n') {
+            position.line++;
+            position.column = 1;
+        } else {
+            position.column++;
+        }
+    }
+
+    return position;
+}
+
+int main(const int argc, const char** argv)
+{
+    laxer_test::fuzz_input fuzz;
+
+    // 随机位置的换行符, 覆盖SIMD块的边界和末尾不足16字节的部分
+    for (std::size_t size : {0, 1, 15, 16, 17, 100, 1000}) {
+        std::string text(size, 'a');
+        for (auto& ch : text) {
+            ch = "\nab c"[fuzz.below(5)];
+        }
+
+        laxer::line_index index(text);
+        assert(not index.is_built());
+        assert(index.get_line_count() == laxer::line_index::count_lines(text) + 1);
+        assert(index.is_built());
+
+        for (std::size_t offset = 0; offset <= text.size(); offset++) {
+            assert(index.locate(offset) == rescan(text, offset));
+        }
+    }
+
+    laxer::line_index lines("first\n\nthird line\n");
+    assert(lines.get_line_count() == 4);
+    assert(lines.get_line(1) == "first" and lines.get_line(2).empty());
+    assert(lines.get_line(3) == "third line" and lines.get_line(4).empty());
+    assert((lines.locate(9) == laxer::line_index::position_t {3, 3}));
+
+    // 通过游标查询token的位置
+    const std::string input = "let x = 1;\n"
+                              "  if (x) {\n"
+                              "\ty = @;\n"
+                              "  }\n";
+
+    laxer::laxer l(input);
+    l.add_rule("[a-z]+", 0, {}, "words");
+    l.add_rule("\\d+", 1, {}, "numbers");
+    l.add_rule("[=;(){}]", 2, {}, "operators");
+    l.add_skip_rule("[ \t\n]+", "spaces");
+
+    std::size_t count = 0;
+    for (auto token = l.next_token(); not token.is_eof(); token = l.next_token()) {
+        assert(l.locate(token) == rescan(input, token.get_offset()));
+
+        if (token.is_default()) {
+            assert((l.locate(token) == laxer::line_index::position_t {3, 6}));
+        }
+        count++;
+    }
+    assert((l.locate(input.size()) == laxer::line_index::position_t {5, 1}));
+
+    // 切换输入后重新扫描
+    l.reset("a\nb");
+    assert((l.locate(2) == laxer::line_index::position_t {2, 1}));
+
+    // 流输入不保存已读过的输入
+    std::stringbuf sb(input);
+    laxer::laxer stream(&sb, 4);
+    bool thrown = false;
+    try {
+        stream.locate(0);
+    } catch (const laxer::laxer::laxer_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << std::format("{} tokens located\n", count);
+    std::cout << "line index test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <cassert>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#include "laxer.hpp"
+#include "token.hpp"
+
+int main(const int argc, const char** argv)
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto path = dir / "laxer_mapped_file_test.edl";
+    const auto empty_path = dir / "laxer_mapped_file_test_empty.edl";
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "123 abc\n456";
+        std::ofstream empty(empty_path, std::ios::binary);
+    }
+
+    laxer::laxer l;
+
+    l.add_rule("\\d+", 0, {}, "numbers");
+    l.add_rule("[a-z]+", 1, {}, "identifiers");
+    l.add_rule("[ \r\n\t]", 2, laxer::converter::ignore, "ignores");
+
+    l.open(path);
+
+    auto token = l.next_token();
+    assert(token.get_token_id() == 0 and token.get_matched_text() == "123");
+
+    token = l.next_token();
+    assert(token.get_token_id() == 1 and token.get_matched_text() == "abc");
+
+    token = l.next_token();
+    assert(token.get_token_id() == 0 and token.get_matched_text() == "456");
+    assert(token.get_offset() == 8);
+
+    assert(l.next_token().is_eof());
+
+    // 空文件直接返回EOF
+    l.open(empty_path);
+    assert(l.next_token().is_eof());
+
+    // 打开不存在的文件时抛出异常
+    bool thrown = false;
+    try {
+        l.open(dir / "laxer_mapped_file_test_missing.edl");
+    } catch (const std::system_error& e) {
+        std::cout << std::format("expected error: {}\n", e.what());
+        thrown = true;
+    }
+    assert(thrown);
+
+    // 目录可以被打开但无法映射, 关闭文件描述符后异常仍需携带映射失败的错误码
+    const auto dir_path = dir / "laxer_mapped_file_test_dir";
+    std::filesystem::create_directory(dir_path);
+    std::ofstream(dir_path / "entry") << "x";
+
+    thrown = false;
+    try {
+        l.open(dir_path);
+    } catch (const std::system_error& e) {
+        std::cout << std::format("expected error: {}\n", e.what());
+        assert(e.code() != std::error_code {});
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::filesystem::remove_all(dir_path);
+    std::filesystem::remove(path);
+    std::filesystem::remove(empty_path);
+
+    return 0;
+}
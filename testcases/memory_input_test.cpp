@@ -0,0 +1,62 @@
+#include <cassert>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <variant>
+
+#include "laxer.hpp"
+#include "token.hpp"
+
+int main(const int argc, const char** argv)
+{
+    const std::string_view input = "123 0x1F abc 0b101";
+
+    laxer::laxer l(input);
+
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("0x[a-fA-F0-9]+", 1, laxer::converter::hex, "hex numbers");
+    l.add_rule("0b[01]+", 2, laxer::converter::bin, "bin numbers");
+    l.add_rule("[a-z]+", 3, {}, "identifiers");
+    l.add_rule("[ \r\n\t]", 4, laxer::converter::ignore, "ignores");
+
+    struct expected_t
+    {
+        laxer::token::id_t id;
+        std::string_view text;
+        std::size_t offset;
+    };
+
+    const expected_t expected[] = {
+        {0, "123",   0 },
+        {1, "0x1F",  4 },
+        {3, "abc",   9 },
+        {2, "0b101", 13},
+    };
+
+    for (const auto& [id, text, offset] : expected) {
+        auto token = l.next_token();
+
+        std::cout << std::format("{}\n", token);
+
+        assert(token.get_token_id() == id);
+        assert(token.get_matched_text() == text);
+        assert(token.get_offset() == offset);
+        assert(l.get_rule(token.get_rule_id()).get_token_id() == id);
+
+        // token文本必须是输入缓冲区的视图, 而不是拷贝
+        assert(token.get_matched_text().data() == input.data() + offset);
+    }
+
+    assert(l.next_token().is_eof());
+    assert(l.get_rule_name(laxer::token()) == "EOF");
+    assert(l.get_rule(1).get_name() == "hex numbers");
+
+    // 复用已生成的DFA处理新的输入
+    l.reset("42");
+    auto token = l.next_token();
+    assert(token.get_token_id() == 0);
+    assert(std::get<std::uint64_t>(token.get_token_value()) == 42);
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "laxer.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+enum tokens
+{
+    identifier,
+    quote,
+    string_content,
+    newline,
+};
+
+void setup_rules(laxer::laxer& l)
+{
+    auto string_mode  = l.add_mode("STRING");
+    auto comment_mode = l.add_mode("COMMENT");
+
+    // 初始模式
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", tokens::identifier, {}, "identifiers");
+    l.add_rule("[ \r\n\t]+", 10, laxer::converter::ignore, "ignores");
+    l.add_mode_rule({laxer::token::initial_mode}, "\"", tokens::quote, {}, "open quote",
+                    string_mode);
+    // 由回调切换模式, 注释本身被丢弃
+    l.add_rule("/\\*", 11, [comment_mode](laxer::token& token) {
+        token.set_next_mode(comment_mode);
+        return false;
+    });
+
+    // 字符串模式: 标识符和空白都属于字符串内容
+    l.add_mode_rule({string_mode}, "[^\"]+", tokens::string_content, {}, "content");
+    l.add_mode_rule({string_mode}, "\n", tokens::newline, {}, "newline");
+    l.add_mode_rule({string_mode}, "\"", tokens::quote, {}, "close quote",
+                    laxer::token::initial_mode);
+
+    // 注释模式
+    l.add_mode_rule({comment_mode}, "\\*/", 12, laxer::converter::ignore, "comment end",
+                    laxer::token::initial_mode);
+    l.add_mode_rule({comment_mode}, "[^*]+|\\*|[\r\n]+", 13, laxer::converter::ignore,
+                    "comment");
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input;
+    for (int i = 0; i < 100; i++) {
+        input += std::format("name_{} \"string {} with words\nand lines\" /* comment "
+                             "\"{}\" * name */ tail_{}\n",
+                             i, i, i, i);
+    }
+
+    laxer::laxer l(input);
+    setup_rules(l);
+
+    std::vector<laxer::token> expected;
+    for (auto token = l.next_token(); not token.is_eof(); token = l.next_token()) {
+        expected.push_back(token);
+    }
+
+    assert(expected.size() == 100 * 7);
+    assert(l.get_mode() == laxer::token::initial_mode);
+    assert(expected[1].get_token_id() == tokens::quote);
+    assert(expected[2].get_token_id() == tokens::string_content);
+    assert(expected[2].get_matched_text() == "string 0 with words");
+    assert(expected[3].get_token_id() == tokens::newline);
+    assert(expected[6].get_matched_text() == "tail_0");
+    assert(l.get_rule_name(expected[1]) == "open quote");
+    assert(l.get_mode_name(1) == "STRING");
+
+    auto same = [&expected](const laxer::token_columns& columns) {
+        if (columns.size() != expected.size()) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < expected.size(); i++) {
+            if (columns.get_ids()[i] != expected[i].get_token_id()
+                or columns.get_offsets()[i] != expected[i].get_offset()
+                or columns.get_lengths()[i] != expected[i].get_length()) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    // 批量和并行接口得到相同的结果
+    l.reset(input);
+    assert(same(l.tokenize_all()));
+    l.reset(input);
+    assert(same(l.tokenize_parallel(4)));
+
+    // 流输入
+    std::stringbuf buffer(input);
+    laxer::laxer streamed(&buffer, 7);
+    setup_rules(streamed);
+    assert(same(streamed.tokenize_all()));
+
+    // 推送式输入
+    laxer::token_columns pushed;
+    auto lexer = l.make_push_lexer([&pushed](const laxer::token& token) {
+        if (not token.is_eof()) {
+            pushed.push_back(token.get_token_id(), token.get_offset(),
+                             token.get_length());
+        }
+    });
+    for (std::size_t pos = 0; pos < input.size(); pos += 5) {
+        auto chunk = std::string_view(input).substr(pos, 5);
+        lexer.feed(std::span<const char>(chunk.data(), chunk.size()));
+    }
+    lexer.finish();
+    assert(same(pushed));
+
+    // 增量输入: 删除一个引号会改变之后所有token所处的模式
+    auto incremental = l.make_incremental_lexer();
+    incremental.lex(input);
+    assert(same(incremental.get_columns()));
+
+    std::string edited = input;
+    std::size_t pos    = edited.find('"');
+    edited.erase(pos, 1);
+    incremental.apply(edited, {pos, 1, ""});
+
+    l.reset(edited);
+    auto reference = l.tokenize_all();
+    edited.insert(pos, "\"");
+    incremental.apply(edited, {pos, 0, "\""});
+    assert(same(incremental.get_columns()));
+    assert(reference.size() != expected.size());
+
+    // 手动切换模式
+    l.reset("abc");
+    l.set_mode(1);
+    assert(l.next_token().get_token_id() == tokens::string_content);
+
+    std::cout << "mode test passed\n";
+
+    return 0;
+}
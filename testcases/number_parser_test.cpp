@@ -0,0 +1,154 @@
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <variant>
+
+#include "fuzz_input.hpp"
+#include "laxer.hpp"
+#include "number_parser.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+using laxer::number_parser;
+
+// convert为false时规则不带回调, 之后批量转换
+void setup_rules(laxer::laxer& l, bool convert)
+{
+    using action_t = laxer::token::action_t;
+
+    l.add_rule("\\d+", 0, convert ? laxer::converter::dec : action_t {}, "numbers");
+    l.add_rule("0x[a-fA-F0-9]+", 1, convert ? laxer::converter::hex : action_t {},
+               "hex numbers");
+    l.add_rule("0b[01]+", 2, convert ? laxer::converter::bin : action_t {},
+               "bin numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 3, {}, "identifiers");
+    l.add_skip_rule("[ \r\n\t]+", "spaces");
+}
+
+std::errc dec(std::string_view text, std::uint64_t& value)
+{
+    return number_parser::parse_dec(text, value);
+}
+
+std::string to_base(std::uint64_t value, int base)
+{
+    char buffer[64];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, base);
+
+    return std::string(buffer, end);
+}
+
+int main(const int argc, const char** argv)
+{
+    std::mt19937_64 rng(laxer_test::fuzz_seed);
+    std::uint64_t value = 0;
+
+    // 各种位数的随机值与其文本往返
+    for (int round = 0; round < 20000; round++) {
+        std::uint64_t expected = rng() >> (rng() % 64);
+
+        assert(dec(std::format("{}", expected), value) == std::errc {});
+        assert(value == expected);
+        assert(number_parser::parse_hex("0x" + to_base(expected, 16), value)
+               == std::errc {});
+        assert(value == expected);
+        assert(number_parser::parse_bin("0b" + to_base(expected, 2), value)
+               == std::errc {});
+        assert(value == expected);
+    }
+
+    // 边界和溢出, 出错时不修改value
+    assert(dec("18446744073709551615", value) == std::errc {} and value == ~0ull);
+    assert(dec("18446744073709551616", value) == std::errc::result_out_of_range);
+    assert(dec("99999999999999999999", value) == std::errc::result_out_of_range);
+    assert(dec("123456789012345678901", value) == std::errc::result_out_of_range);
+    assert(value == ~0ull);
+    assert(dec("000000000000000000000000042", value) == std::errc {} and value == 42);
+    assert(dec("0", value) == std::errc {} and value == 0);
+    assert(dec("", value) == std::errc::invalid_argument);
+    assert(dec("1234567a", value) == std::errc::invalid_argument);
+    assert(dec("12345678:", value) == std::errc::invalid_argument);
+    assert(dec("1234567890123456789012x", value) == std::errc::invalid_argument);
+
+    assert(number_parser::parse_hex("0xffffffffffffffff", value) == std::errc {});
+    assert(value == ~0ull);
+    assert(number_parser::parse_hex("0x10000000000000000", value)
+           == std::errc::result_out_of_range);
+    assert(number_parser::parse_hex("0x45g6", value) == std::errc::invalid_argument);
+    assert(number_parser::parse_hex("0X00aB", value) == std::errc {} and value == 0xab);
+
+    // 超过32位的二进制数不再截断
+    std::string bits = "0b1" + std::string(63, '0');
+    assert(number_parser::parse_bin(bits, value) == std::errc {} and value == 1ull << 63);
+    assert(number_parser::parse_bin(bits + "0", value) == std::errc::result_out_of_range);
+    assert(number_parser::parse_bin("0b10102", value) == std::errc::invalid_argument);
+    assert(number_parser::parse_bin("0b11111111", value) == std::errc {});
+    assert(value == 255);
+
+    double real = 0;
+    assert(number_parser::parse_fp64("3.25", real) == std::errc {} and real == 3.25);
+    assert(number_parser::parse_fp64("1e999", real) == std::errc::result_out_of_range);
+    assert(number_parser::parse_fp64("1.5x", real) == std::errc::invalid_argument);
+    assert(real == 3.25);
+
+    // 回调中的转换: 溢出的token仍然保留, 值为空
+    const std::string input = "123 456\n6 09 8\n0x123 7 0x98adE\n"
+                              "0b1111 0b0010 0b1010\n114514\n99999999999999999999 0b"
+                            + std::string(40, '1') + "\n";
+
+    laxer::laxer converted(input);
+    setup_rules(converted, true);
+
+    auto token = converted.next_token();
+    while (token.get_token_id() != 0 or token.get_length() != 20) {
+        assert(not token.is_eof());
+        token = converted.next_token();
+    }
+    assert(std::holds_alternative<std::monostate>(token.get_token_value()));
+    assert(token.convert_dec() == std::errc::result_out_of_range);
+
+    token = converted.next_token();
+    assert(std::get<std::uint64_t>(token.get_token_value()) == (1ull << 40) - 1);
+
+    // 批量转换与逐个token的回调得到相同的值列
+    converted.reset(input);
+    auto expected = converted.tokenize_all(true);
+
+    laxer::laxer plain(input);
+    setup_rules(plain, false);
+    auto columns = plain.tokenize_all(true);
+
+    assert(columns.convert_numbers(input, 0, number_parser::format_t::dec) == 1);
+    assert(columns.convert_numbers(input, 1, number_parser::format_t::hex) == 0);
+    assert(columns.convert_numbers(input, 2, number_parser::format_t::bin) == 0);
+
+    assert(columns.size() == expected.size());
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        assert(columns.get_values()[i] == expected.get_values()[i]);
+    }
+    assert(std::get<std::uint64_t>(columns.get_values()[3]) == 9);
+
+    // 传入较短的输入时越界的token计为失败, 不抛出异常
+    std::size_t decimal_count = 0;
+    for (auto id : columns.get_ids()) {
+        decimal_count += id == 0;
+    }
+
+    const std::string_view truncated = std::string_view(input).substr(0, 7);
+    assert(columns.convert_numbers(truncated, 0, number_parser::format_t::dec)
+           == decimal_count - 2);
+    assert(std::get<std::uint64_t>(columns.get_values()[1]) == 456);
+    assert(std::holds_alternative<std::monostate>(columns.get_values()[2]));
+
+    std::cout << std::format("{} tokens converted\n", columns.size());
+    std::cout << "number parser test passed\n";
+
+    return 0;
+}
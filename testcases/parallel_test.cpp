@@ -0,0 +1,63 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include "laxer.hpp"
+#include "parallel.hpp"
+#include "same_columns.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 1, {}, "identifiers");
+    // 字符串中的空格和标识符会让从块边界开始的推测出错
+    l.add_rule("\"[^\"]*\"", 2, laxer::converter::string, "strings");
+    l.add_rule("[ \r\n\t]+", 3, laxer::converter::ignore, "ignores");
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input;
+    for (int i = 0; i < 200; i++) {
+        input += std::format("ident_{} {} \"a string with {} words and spaces\" ? ", i,
+                             i * 7, i);
+
+        // 偶尔出现跨越多个块的长token
+        if (i % 50 == 0) {
+            input += std::format("\"{}\" ", std::string(i * 10 + 100, 'x'));
+        }
+    }
+
+    laxer::laxer l(input);
+    setup_rules(l);
+
+    auto expected = l.tokenize_all(true);
+    std::cout << std::format("{} tokens\n", expected.size());
+
+    for (std::size_t thread_count : {1, 2, 3, 4, 7, 16}) {
+        for (std::size_t min_chunk_size : {1, 17, 256, 4096}) {
+            auto result = laxer::parallel_lexer::tokenize(l.get_table(), l.get_rules(),
+                                                          input, 0, thread_count, true,
+                                                          min_chunk_size);
+
+            assert(laxer_test::same_columns(result, expected));
+        }
+    }
+
+    // 从已经消耗了部分输入的位置继续
+    laxer::laxer partial(input);
+    setup_rules(partial);
+
+    auto first = partial.next_token();
+    auto rest  = partial.tokenize_parallel(4, true);
+    assert(first.get_offset() == 0);
+    assert(rest.size() + 1 == expected.size());
+    assert(rest.get_offsets()[0] == expected.get_offsets()[1]);
+    assert(partial.next_token().is_eof());
+
+    return 0;
+}
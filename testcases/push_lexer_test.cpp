@@ -0,0 +1,136 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "laxer.hpp"
+#include "push_lexer.hpp"
+#include "token.hpp"
+
+struct record
+{
+    laxer::token::id_t rule_id;
+    std::size_t offset;
+    std::string text;
+    laxer::token::value_t value;
+
+    bool operator==(const record&) const = default;
+};
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 1, {}, "identifiers");
+    // 需要回退的规则: "abcd"匹配失败时退回到"ab"
+    l.add_rule("abcd", 2, {}, "abcd");
+    l.add_rule("\"[^\"]*\"", 3, {}, "strings");
+    l.add_rule(std::string("<\0>", 3), 4, {}, "nul");
+    l.add_rule("[ \r\n\t]+", 5, laxer::converter::ignore, "ignores");
+}
+
+record to_record(const laxer::token& token)
+{
+    auto value = token.get_token_value();
+
+    // 字符串值引用的是输入, 不参与比较
+    if (std::holds_alternative<std::string_view>(value)) {
+        value = std::monostate {};
+    }
+
+    return {token.get_rule_id(), token.get_offset(),
+            std::string(token.get_matched_text()), value};
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input;
+    for (int i = 0; i < 50; i++) {
+        input += std::format("abc{} ab abcd \"string {}\" {} ", i, i, i * 13);
+        input += std::string("<\0> ? ", 6);
+    }
+    input += "abc";
+
+    laxer::laxer l(input);
+    setup_rules(l);
+
+    std::vector<record> expected;
+    for (auto token = l.next_token(); not token.is_eof(); token = l.next_token()) {
+        expected.push_back(to_record(token));
+    }
+
+    for (std::size_t chunk_size = 1; chunk_size <= input.size(); chunk_size *= 3) {
+        std::vector<record> records;
+        bool finished = false;
+
+        auto lexer = l.make_push_lexer([&](const laxer::token& token) {
+            if (token.is_eof()) {
+                assert(token.get_offset() == input.size());
+                finished = true;
+                return;
+            }
+
+            records.push_back(to_record(token));
+        });
+
+        for (std::size_t pos = 0; pos < input.size(); pos += chunk_size) {
+            std::string chunk = input.substr(pos, chunk_size);
+            lexer.feed(std::span<const char>(chunk.data(), chunk.size()));
+        }
+
+        assert(not finished);
+        lexer.finish();
+
+        assert(finished);
+        assert(records == expected);
+        assert(lexer.get_pending_size() == 0);
+
+        std::cout << std::format("chunk size {} passed\n", chunk_size);
+    }
+
+    // 一个token跨越多个数据块
+    std::size_t count = 0;
+    auto lexer        = l.make_push_lexer([&](const laxer::token& token) {
+        if (not token.is_eof()) {
+            assert(token.get_matched_text().size() == 1002);
+            count++;
+        }
+    });
+
+    std::string chunk(100, 'x');
+    lexer.feed(std::span<const char>("\"", 1));
+    for (int i = 0; i < 10; i++) {
+        lexer.feed(std::span<const char>(chunk.data(), chunk.size()));
+    }
+    assert(lexer.get_pending_size() == 1001);
+    lexer.feed(std::span<const char>("\" ", 2));
+    assert(count == 1);
+    lexer.finish();
+
+    // laxer重新编译后, 之前创建的对象仍然使用原来的编译结果
+    std::vector<record> records;
+    auto shared = l.make_push_lexer([&records](const laxer::token& token) {
+        if (not token.is_eof()) {
+            records.push_back(to_record(token));
+        }
+    });
+    auto incremental = l.make_incremental_lexer();
+
+    l.set_error_runs(true);
+    l.generate_dfa();
+    // 切换步长表同样生成新的编译结果
+    l.set_strides(true);
+
+    shared.feed(std::span<const char>(input.data(), input.size()));
+    shared.finish();
+    assert(records == expected);
+
+    incremental.lex(input);
+    assert(incremental.get_columns().size() == expected.size());
+
+    std::cout << "push lexer test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "token_columns.hpp"
+
+namespace laxer_test {
+    // 比较两个token流的id, 偏移和长度; 任意一方记录了值列时值列也必须相同
+    inline bool same_columns(const laxer::token_columns& a, const laxer::token_columns& b)
+    {
+        if (a.size() != b.size()) {
+            return false;
+        }
+
+        if ((a.has_values() or b.has_values())
+            and not std::ranges::equal(a.get_values(), b.get_values())) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < a.size(); i++) {
+            if (a.get_ids()[i] != b.get_ids()[i]
+                or a.get_offsets()[i] != b.get_offsets()[i]
+                or a.get_lengths()[i] != b.get_lengths()[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+} // namespace laxer_test
@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "dfa_table.hpp"
+#include "fuzz_input.hpp"
+#include "laxer.hpp"
+#include "nfa.hpp"
+#include "regex/regex.hpp"
+#include "shuffle_dfa.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, {}, "numbers");
+    l.add_rule("0x[0-9a-fA-F]+", 1, {}, "hex numbers");
+    // 包含哨兵字节的规则
+    l.add_rule(std::string("<\0>", 3), 2, {}, "nul");
+    l.add_skip_rule("[ \n]+", "spaces");
+}
+
+// 逐个token比较两张表的匹配结果
+bool same_matches(const laxer::dfa_table& a, const laxer::dfa_table& b,
+                  std::string_view input)
+{
+    std::size_t offset_a = 0, offset_b = 0;
+    laxer::dfa_table::id_t mode_a = 0, mode_b = 0;
+
+    while (offset_a < input.size()) {
+        std::size_t end_a = offset_a, end_b = offset_b;
+
+        auto rule_a = a.match_token(input, offset_a, end_a, mode_a);
+        auto rule_b = b.match_token(input, offset_b, end_b, mode_b);
+
+        if (rule_a != rule_b or offset_a != offset_b or end_a != end_b) {
+            return false;
+        }
+
+        if (rule_a == laxer::dfa_table::invalid_state) {
+            end_a = a.unmatched_end(input, offset_a, mode_a);
+        }
+
+        offset_a = offset_b = end_a;
+    }
+
+    return true;
+}
+
+int main(const int argc, const char** argv)
+{
+    // 单独使用: 对一个很长的字段按块并行计算状态映射后复合
+    laxer::nfa hex_nfa;
+    hex_nfa.add_nfa(regex::build_nfa("0x[0-9a-fA-F]+"), 7);
+
+    laxer::shuffle_dfa hex(regex::build(hex_nfa));
+    assert(laxer::shuffle_dfa::fits(hex.get_state_count()));
+
+    assert(hex.match("0xFF") == 7);
+    assert(hex.match("0x") == laxer::shuffle_dfa::invalid_state);
+    assert(hex.match("0xFG") == laxer::shuffle_dfa::invalid_state);
+
+    laxer_test::fuzz_input fuzz({"0", "42", "0x", "0xff", "0xg", " ", "\n", "<", ">", "#",
+                                 std::string("<\0>", 3), std::string("\0", 1)});
+    const std::string digits = "0123456789abcdefABCDEF";
+
+    std::string field = "0x";
+    for (int i = 0; i < 1 << 20; i++) {
+        field.push_back(digits[fuzz.below(digits.size())]);
+    }
+
+    for (bool simd : {false, true}) {
+        hex.set_simd(simd);
+
+        assert(hex.match(field, 1) == 7);
+        assert(hex.run(field, hex.get_start(), 4, 1024)
+               == hex.run(field, hex.get_start()));
+
+        // 无效字节出现在某一块中间时, 死状态经过后续块的映射后保持不变
+        std::string bad = field;
+        bad[bad.size() / 3] = 'x';
+        assert(hex.run(bad, hex.get_start(), 4, 1024)
+               == laxer::shuffle_dfa::invalid_state);
+    }
+
+    // 映射的复合与整体计算相同
+    auto whole = hex.compose("0x1f");
+    auto split = laxer::shuffle_dfa::then(hex.compose("0x"), hex.compose("1f"));
+    assert(whole == split);
+
+    // 作为dfa_table的内层循环: 与不使用字节重排的表逐个token比较
+    laxer::laxer l;
+    setup_rules(l);
+    l.generate_dfa();
+
+    const auto& table = l.get_table();
+    assert(table.has_shuffle() and table.uses_shuffle());
+
+    laxer::dfa_table plain = table;
+    plain.clear_shuffle();
+
+    // 显式生成的两字节步长表优先于字节重排表
+    laxer::dfa_table strided = table;
+    assert(strided.build_strides());
+    assert(strided.has_shuffle() and not strided.uses_shuffle());
+
+    for (int round = 0; round < 200; round++) {
+        auto input = fuzz.next(60);
+
+        assert(same_matches(table, plain, input));
+        assert(same_matches(strided, plain, input));
+    }
+
+    std::cout << std::format("{} states, simd {}\n", table.get_state_count(),
+                             laxer::shuffle_dfa(regex::build(hex_nfa)).is_simd());
+    std::cout << "shuffle dfa test passed\n";
+
+    return 0;
+}
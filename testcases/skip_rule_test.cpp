@@ -0,0 +1,111 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <span>
+#include <sstream>
+#include <string>
+
+#include "laxer.hpp"
+#include "same_columns.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+// skip为true时空白和注释使用跳过规则, 否则使用converter::ignore
+void setup_rules(laxer::laxer& l, bool skip)
+{
+    auto comment_mode = l.add_mode("COMMENT");
+
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 1, {}, "identifiers");
+
+    if (skip) {
+        l.add_skip_rule("[ \r\n\t]+", "spaces");
+        l.add_mode_skip_rule({laxer::token::initial_mode}, "/\\*", "comment begin",
+                             comment_mode);
+        l.add_mode_skip_rule({comment_mode}, "\\*/", "comment end",
+                             laxer::token::initial_mode);
+        l.add_mode_skip_rule({comment_mode}, "[^*]+|\\*|[\r\n]+", "comment");
+    } else {
+        l.add_rule("[ \r\n\t]+", 2, laxer::converter::ignore, "spaces");
+        l.add_mode_rule({laxer::token::initial_mode}, "/\\*", 3,
+                        laxer::converter::ignore, "comment begin", comment_mode);
+        l.add_mode_rule({comment_mode}, "\\*/", 3, laxer::converter::ignore,
+                        "comment end", laxer::token::initial_mode);
+        l.add_mode_rule({comment_mode}, "[^*]+|\\*|[\r\n]+", 3,
+                        laxer::converter::ignore, "comment");
+    }
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input;
+    for (int i = 0; i < 300; i++) {
+        input +=
+            std::format("name_{}  {}\t/* comment {} * with\n lines */\n", i, i * 3, i);
+    }
+    // 以跳过的内容结尾
+    input += "  /* tail */ \n";
+
+    laxer::laxer ignored(input);
+    setup_rules(ignored, false);
+    auto expected = ignored.tokenize_all(true);
+    assert(expected.size() == 600);
+
+    laxer::laxer skipped(input);
+    setup_rules(skipped, true);
+
+    // 逐个匹配, 跳过的内容不会作为token返回, 最后直接得到EOF
+    std::size_t count = 0;
+    for (auto token = skipped.next_token(); not token.is_eof();
+         token      = skipped.next_token()) {
+        assert(token.get_token_id() == expected.get_ids()[count]);
+        assert(token.get_offset() == expected.get_offsets()[count]);
+        count++;
+    }
+    assert(count == expected.size());
+    assert(skipped.get_offset() == input.size());
+
+    skipped.reset(input);
+    assert(laxer_test::same_columns(skipped.tokenize_all(true), expected));
+
+    // 流输入
+    std::stringbuf buffer(input);
+    laxer::laxer streamed(&buffer, 13);
+    setup_rules(streamed, true);
+    assert(laxer_test::same_columns(streamed.tokenize_all(true), expected));
+
+    // 推送式输入
+    laxer::token_columns pushed(true);
+    auto lexer = skipped.make_push_lexer([&pushed](const laxer::token& token) {
+        if (not token.is_eof()) {
+            pushed.push_back(token.get_token_id(), token.get_offset(),
+                             token.get_length(), token.get_token_value());
+        }
+    });
+    for (std::size_t pos = 0; pos < input.size(); pos += 9) {
+        auto chunk = std::string_view(input).substr(pos, 9);
+        lexer.feed(std::span<const char>(chunk.data(), chunk.size()));
+    }
+    lexer.finish();
+    assert(laxer_test::same_columns(pushed, expected));
+
+    // 只有一个模式时的并行匹配
+    laxer::laxer single(input);
+    single.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    single.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 1, {}, "identifiers");
+    single.add_skip_rule("[ \r\n\t]+", "spaces");
+    // 取反的字符集不包含换行符
+    single.add_skip_rule("/\\*([^*]|[\r\n]|\\*+([^*/]|[\r\n]))*\\*+/", "comment");
+
+    auto sequential = single.tokenize_all(true);
+    single.reset(input);
+    auto parallel = laxer::parallel_lexer::tokenize(
+        single.get_table(), single.get_rules(), input, 0, 4, true, 256);
+    assert(laxer_test::same_columns(sequential, expected));
+    assert(laxer_test::same_columns(parallel, expected));
+
+    std::cout << "skip rule test passed\n";
+
+    return 0;
+}
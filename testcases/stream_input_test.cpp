@@ -0,0 +1,117 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "input.hpp"
+#include "laxer.hpp"
+#include "token.hpp"
+
+struct record_t
+{
+    laxer::token::id_t id;
+    std::string text;
+    std::size_t offset;
+
+    bool operator==(const record_t&) const = default;
+};
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, {}, "numbers");
+    l.add_rule("0x[a-fA-F0-9]+", 1, {}, "hex numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 2, {}, "identifiers");
+    l.add_rule("\"[^\"]*\"", 3, {}, "strings");
+    // 包含哨兵字节的规则
+    l.add_rule(std::string("<\0>", 3), 4, {}, "nul");
+    l.add_rule("[ \r\n\t]+", 5, laxer::converter::ignore, "ignores");
+}
+
+std::vector<record_t> collect(laxer::laxer& l)
+{
+    std::vector<record_t> result;
+
+    for (auto token = l.next_token(); not token.is_eof();
+         token = l.next_token()) {
+        // 流输入模式下token文本仅在下一次调用next_token前有效, 需要立即拷贝
+        result.emplace_back(token.get_token_id(), std::string(token.get_matched_text()),
+                            token.get_offset());
+    }
+
+    return result;
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input = "abc 123 0xFF \"a long string literal\" <";
+    input.push_back('\0');
+    input += "> ident_with_digits_42 ?";
+
+    for (int i = 0; i < 4; i++) {
+        input += input;
+    }
+
+    // 以跨越最后一块的token结束
+    input += " tail_token";
+
+    laxer::laxer memory(input);
+    setup_rules(memory);
+    auto expected = collect(memory);
+
+    // 使用不同的块大小, 使token跨越块边界; 后台预读时比一块还长的token需要拷贝而不是交换
+    for (bool prefetch : {false, true}) {
+        for (std::size_t chunk_size : {1, 2, 3, 7, 64, 65536}) {
+            std::stringbuf sb(input);
+            laxer::laxer stream(&sb, chunk_size, prefetch);
+            setup_rules(stream);
+
+            auto result = collect(stream);
+
+            std::cout << std::format("chunk size {}{}: {} tokens\n", chunk_size,
+                                     prefetch ? " (prefetch)" : "", result.size());
+            assert(result == expected);
+        }
+    }
+
+    // 没有读完就销毁, 预读线程需要退出
+    {
+        std::stringbuf sb(input);
+        laxer::laxer stream(&sb, 16, true);
+        setup_rules(stream);
+        stream.next_token();
+    }
+
+    // 移动赋值覆盖正在预读的对象, 它的预读线程同样需要退出
+    {
+        std::stringbuf first(input);
+        std::stringbuf second("abc def");
+        laxer::stream_input stream(&first, 16, true);
+
+        stream = laxer::stream_input(&second, 16, true);
+        assert(stream.refill(0));
+        assert(stream.window() == "abc def");
+        assert(not stream.refill(0));
+    }
+
+    // 输入在token中间结束, 且短于一块
+    for (std::size_t chunk_size : {4, 64}) {
+        std::stringbuf sb("abc def");
+        laxer::laxer stream(&sb, chunk_size);
+        setup_rules(stream);
+
+        assert((collect(stream)
+                == std::vector<record_t> {{2, "abc", 0}, {2, "def", 4}}));
+    }
+
+    std::size_t nul_count = 0;
+    for (const auto& [id, text, offset] : expected) {
+        assert(input.compare(offset, text.size(), text) == 0);
+        nul_count += (id == 4);
+    }
+    assert(nul_count == 16);
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include "fuzz_input.hpp"
+#include "laxer.hpp"
+#include "same_columns.hpp"
+#include "token.hpp"
+#include "token_columns.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    auto string_mode = l.add_mode("STRING");
+
+    l.add_rule("a", 0, {}, "a");
+    l.add_rule("abc", 1, {}, "abc");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 2, {}, "identifiers");
+    // "3.x"需要回退到两字节之间的终态"3"
+    l.add_rule("\\d+(\\.\\d+)?", 3, {}, "numbers");
+    l.add_rule(std::string("<\0\0>", 4), 4, {}, "nul");
+    l.add_skip_rule("[ \r\n\t]+", "spaces");
+    l.add_mode_rule({laxer::token::initial_mode}, "\"", 5, {}, "open quote", string_mode);
+    l.add_mode_rule({string_mode}, "[^\"]+", 6, {}, "content");
+    l.add_mode_rule({string_mode}, "\"", 5, {}, "close quote",
+                    laxer::token::initial_mode);
+}
+
+int main(const int argc, const char** argv)
+{
+    laxer::laxer plain;
+    setup_rules(plain);
+
+    laxer::laxer strided;
+    setup_rules(strided);
+    strided.set_strides(true);
+    strided.generate_dfa();
+    assert(strided.get_table().has_strides());
+    assert(not plain.get_table().has_strides());
+
+    // 两字节之间的终态
+    strided.reset("3.x");
+    auto token = strided.next_token();
+    assert(token.get_matched_text() == "3" and token.get_token_id() == 3);
+
+    laxer_test::fuzz_input fuzz({"a", "ab", "abc", "abcd", "x", "long_identifier_42",
+                                 "3", "3.14", "12.", " ", "\n", "\"", "\"str ing\"", "#",
+                                 std::string("<\0\0>", 4), std::string("\0", 1)});
+
+    for (int round = 0; round < 200; round++) {
+        auto input = fuzz.next(60);
+
+        plain.reset(input);
+        strided.reset(input);
+        assert(laxer_test::same_columns(strided.tokenize_all(), plain.tokenize_all()));
+    }
+
+    // 启用后生成的表可以关闭, 表过大时不生成
+    strided.set_strides(false);
+    assert(not strided.get_table().has_strides());
+
+    laxer::dfa_table table = plain.get_table();
+    assert(not table.build_strides(1));
+    assert(table.build_strides());
+
+    std::cout << std::format("{} states, {} byte classes\n", table.get_state_count(),
+                             table.get_class_count());
+    std::cout << "stride test passed\n";
+
+    return 0;
+}
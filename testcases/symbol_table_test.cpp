@@ -0,0 +1,125 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "laxer.hpp"
+#include "symbol_table.hpp"
+#include "token.hpp"
+
+void setup_rules(laxer::laxer& l, laxer::symbol_table& symbols)
+{
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 0, laxer::converter::intern(symbols),
+               "identifiers");
+    l.add_rule("\\d+", 1, laxer::converter::dec, "numbers");
+    l.add_rule("[-+*/=;(){}]", 2, {}, "operators");
+    l.add_skip_rule("[ \t\r\n]+", "spaces");
+}
+
+// 所有标识符token的符号id
+std::vector<laxer::symbol_table::id_t> symbol_ids(laxer::laxer& l)
+{
+    std::vector<laxer::symbol_table::id_t> ids;
+
+    for (auto token = l.next_token(); not token.is_eof(); token = l.next_token()) {
+        if (auto symbol = std::get_if<laxer::token::symbol_t>(&token.get_token_value())) {
+            assert(token.get_token_id() == 0);
+            ids.push_back(symbol->id);
+        }
+    }
+
+    return ids;
+}
+
+int main(const int argc, const char** argv)
+{
+    // 去重, id连续且稳定
+    laxer::symbol_table table;
+    assert(table.empty());
+    assert(table.find("x") == laxer::symbol_table::invalid_id);
+
+    assert(table.intern("x") == 0);
+    assert(table.intern("counter") == 1);
+    assert(table.intern("x") == 0);
+    assert(table.intern("") == 2);
+    assert(table.intern("") == 2);
+    assert(table.size() == 3);
+    assert(table.find("counter") == 1);
+    assert(table[1] == "counter" and table.get_text(2).empty());
+
+    // 超过一块的长文本单独分配
+    std::string huge(laxer::symbol_table::block_size + 10, 'h');
+    auto huge_id = table.intern(huge);
+    assert(table.intern(huge) == huge_id and table[huge_id] == huge);
+
+    // 多次扩容后已有的id和文本不变, 长度跨过8字节边界的文本互不混淆
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < 20000; i++) {
+        names.push_back(std::format("name_{}_{}", i, std::string(i % 19, 'z')));
+    }
+
+    std::vector<laxer::symbol_table::id_t> ids;
+    for (const auto& name : names) {
+        ids.push_back(table.intern(name));
+    }
+
+    for (std::size_t i = 0; i < names.size(); i++) {
+        assert(ids[i] == huge_id + 1 + i);
+        assert(table.find(names[i]) == ids[i] and table[ids[i]] == names[i]);
+    }
+    assert(table.find("x") == 0);
+    assert(table.find("name_") == laxer::symbol_table::invalid_id);
+
+    // 移动后文本仍然有效, 被移动的表是可以继续使用的空表
+    const auto size = table.size();
+    laxer::symbol_table moved(std::move(table));
+    assert(moved.size() == size and moved.find("counter") == 1);
+    assert(table.empty() and table.find("counter") == laxer::symbol_table::invalid_id);
+    assert(table.intern("y") == 0 and table.find("y") == 0);
+
+    table = std::move(moved);
+    assert(table.size() == size and table[huge_id] == huge);
+    assert(moved.empty() and moved.intern("z") == 0);
+
+    // 词法分析时的驻留: 预先驻留的关键字保持固定的id
+    const std::string input = "let alpha = 1; let beta = alpha + beta_2;\n"
+                              "if (alpha) { beta = alpha * 42; }\n";
+
+    laxer::symbol_table symbols;
+    const auto keyword_let = symbols.intern("let");
+    const auto keyword_if  = symbols.intern("if");
+
+    laxer::laxer l(input);
+    setup_rules(l, symbols);
+    auto expected = symbol_ids(l);
+
+    assert(symbols.size() == 5);
+    const auto alpha = symbols.find("alpha"), beta = symbols.find("beta");
+    assert((expected
+            == std::vector<laxer::symbol_table::id_t> {
+                keyword_let, alpha, keyword_let, beta, alpha, symbols.find("beta_2"),
+                keyword_if, alpha, beta, alpha}));
+
+    // 流式输入: 窗口移动后符号仍然有效, 与一次性输入得到相同的id
+    for (std::size_t chunk_size : {1, 3, 64}) {
+        std::stringbuf sb(input);
+        laxer::laxer stream(&sb, chunk_size);
+        setup_rules(stream, symbols);
+
+        assert(symbol_ids(stream) == expected);
+        assert(symbols.size() == 5);
+    }
+    assert(symbols[alpha] == "alpha" and symbols[beta] == "beta");
+
+    std::cout << std::format("{} symbols, {} identifiers\n", table.size(),
+                             expected.size());
+    std::cout << "symbol table test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+int main(const int argc, const char** argv)
+{
+    for (std::size_t thread_count = 1; thread_count <= 8; thread_count *= 2) {
+        laxer::thread_pool pool(thread_count);
+        std::atomic<std::size_t> sum = 0;
+
+        // 任务内部继续提交任务
+        for (std::size_t i = 0; i < 1000; i++) {
+            pool.submit([&pool, &sum, i] {
+                sum += i;
+                pool.submit([&sum] { sum++; });
+            });
+        }
+
+        pool.wait();
+        assert(sum == 1000 * 999 / 2 + 1000);
+
+        // 异常在wait中重新抛出, 之后线程池仍然可用
+        pool.submit([] { throw std::runtime_error("task failed"); });
+
+        bool thrown = false;
+        try {
+            pool.wait();
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        pool.submit([&sum] { sum = 0; });
+        pool.wait();
+        assert(sum == 0);
+
+        std::cout << std::format("{} threads passed\n", pool.size());
+    }
+
+    // 同一个队列中的任务按提交顺序执行
+    {
+        laxer::thread_pool pool(1);
+        std::atomic<bool> submitted = false;
+        std::vector<std::size_t> order;
+
+        pool.submit([&submitted] { submitted.wait(false); });
+        for (std::size_t i = 0; i < 10; i++) {
+            pool.submit([&order, i] { order.push_back(i); });
+        }
+
+        submitted = true;
+        submitted.notify_one();
+        pool.wait();
+
+        for (std::size_t i = 0; i < order.size(); i++) {
+            assert(order[i] == i);
+        }
+        assert(order.size() == 10);
+    }
+
+    // 析构时执行完剩余任务
+    std::atomic<std::size_t> count = 0;
+    {
+        laxer::thread_pool pool(4);
+        for (std::size_t i = 0; i < 100; i++) {
+            pool.submit([&count] { count++; });
+        }
+    }
+    assert(count == 100);
+
+    std::cout << "thread pool test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "laxer.hpp"
+#include "token.hpp"
+#include "token_buffer.hpp"
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 1, laxer::converter::string, "identifiers");
+    l.add_rule("[=;]", 2, {}, "operators");
+    l.add_skip_rule("[ \r\n\t]+", "spaces");
+}
+
+std::vector<std::string> collect(laxer::laxer& l)
+{
+    std::vector<std::string> texts;
+
+    for (auto token = l.next_token(); not token.is_eof(); token = l.next_token()) {
+        texts.emplace_back(token.get_matched_text());
+    }
+
+    return texts;
+}
+
+// 在缓冲区上做前瞻, 回溯后逐个消耗, 结果必须与直接匹配一致
+void check(laxer::token_buffer& buffer, const std::vector<std::string>& expected)
+{
+    std::size_t i = 0;
+
+    while (not buffer.peek().is_eof()) {
+        for (std::size_t k = 0; k < 3 and i + k < expected.size(); k++) {
+            assert(buffer.peek(k).get_matched_text() == expected[i + k]);
+        }
+
+        // 试探性地消耗两个token后回到标记处
+        buffer.mark();
+        buffer.consume();
+        if (not buffer.peek().is_eof()) {
+            buffer.consume();
+        }
+        buffer.rewind();
+
+        auto token = buffer.consume();
+        assert(token.get_matched_text() == expected[i]);
+
+        if (token.get_token_id() == 1) {
+            assert(std::get<std::string_view>(token.get_token_value()) == expected[i]);
+        }
+
+        i++;
+    }
+
+    assert(i == expected.size());
+    assert(buffer.consume().is_eof() and buffer.peek().is_eof());
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input;
+    for (int i = 0; i < 300; i++) {
+        input += std::format("name_{} = {} ;\n", i, i * 7);
+    }
+
+    laxer::laxer l(input);
+    setup_rules(l);
+    auto expected = collect(l);
+
+    l.reset(input);
+    laxer::token_buffer buffer(l, 5);
+    assert(buffer.get_capacity() == 8);
+    check(buffer, expected);
+
+    // 流输入时token文本被拷贝到缓冲区, 小块读取也不会失效
+    std::stringbuf stream(input);
+    laxer::laxer streamed(&stream, 16);
+    setup_rules(streamed);
+    laxer::token_buffer stream_buffer(streamed);
+    check(stream_buffer, expected);
+
+    // 嵌套标记, release保持当前位置
+    l.reset(input);
+    laxer::token_buffer nested(l);
+    nested.mark();
+    nested.consume();
+    nested.mark();
+    nested.consume();
+    nested.release();
+    assert(nested.peek().get_matched_text() == expected[2]);
+    nested.rewind();
+    assert(nested.peek().get_matched_text() == expected[0]);
+    assert(nested.get_buffered() == 3);
+
+    // 前瞻超过容量
+    bool thrown = false;
+    try {
+        nested.peek(nested.get_capacity());
+    } catch (const laxer::laxer::laxer_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // 标记之后保留的token同样受容量限制
+    nested.mark();
+    thrown = false;
+    try {
+        for (std::size_t i = 0; i <= nested.get_capacity(); i++) {
+            nested.consume();
+        }
+    } catch (const laxer::laxer::laxer_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    nested.rewind();
+    assert(nested.peek().get_matched_text() == expected[0]);
+
+    // 没有对应的标记
+    for (bool rewind : {true, false}) {
+        thrown = false;
+        try {
+            rewind ? nested.rewind() : nested.release();
+        } catch (const laxer::laxer::laxer_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    assert(nested.peek().get_matched_text() == expected[0]);
+
+    std::cout << std::format("{} tokens\n", expected.size());
+    std::cout << "token buffer test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "laxer.hpp"
+#include "lexer_cursor.hpp"
+#include "token.hpp"
+#include "token_buffer.hpp"
+#include "token_pipeline.hpp"
+
+// laxer不能被切割为lexer_cursor交给流水线
+static_assert(not std::is_constructible_v<laxer::token_pipeline, laxer::laxer&&>);
+static_assert(std::is_constructible_v<laxer::token_pipeline, laxer::lexer_cursor&&>);
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", 0, laxer::converter::dec, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", 1, laxer::converter::string, "identifiers");
+    l.add_rule("[=+;]", 2, {}, "operators");
+    l.add_rule("!", 3,
+               [](laxer::token&) -> bool {
+                   throw std::runtime_error("unexpected !");
+               },
+               "bang");
+    l.add_skip_rule("[ \r\n\t]+", "spaces");
+}
+
+template<typename source_t>
+std::vector<std::string> collect(source_t& source)
+{
+    std::vector<std::string> texts;
+
+    for (auto token = source.next_token(); not token.is_eof();
+         token      = source.next_token()) {
+        texts.emplace_back(token.get_matched_text());
+
+        if (token.get_token_id() == 1) {
+            assert(std::get<std::string_view>(token.get_token_value())
+                   == token.get_matched_text());
+        }
+    }
+
+    // 输入结束后一直返回EOF
+    assert(source.next_token().is_eof());
+
+    return texts;
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input;
+    for (int i = 0; i < 2000; i++) {
+        input += std::format("name_{} = {} + {} ;\n", i, i * 7, i % 13);
+    }
+
+    laxer::laxer l(input);
+    setup_rules(l);
+    auto expected = collect(l);
+
+    for (std::size_t batch_size : {1, 7, 512}) {
+        for (std::size_t batch_count : {1, 2, 4}) {
+            laxer::token_pipeline pipeline(l.make_cursor(input), batch_size, batch_count);
+            assert(collect(pipeline) == expected);
+        }
+    }
+
+    // 流输入时token文本被拷贝到批次中
+    std::stringbuf buffer(input);
+    laxer::token_pipeline streamed(laxer::lexer_cursor(l.share(), &buffer, 32), 16);
+    assert(streamed.is_streaming());
+    assert(collect(streamed) == expected);
+
+    // 可以在流水线上建立前瞻缓冲区
+    laxer::token_pipeline piped(l.make_cursor(input), 8, 2);
+    laxer::token_buffer lookahead(piped);
+    assert(lookahead.peek(2).get_matched_text() == expected[2]);
+    assert(lookahead.consume().get_matched_text() == expected[0]);
+
+    // 回调抛出的异常在读到对应位置时重新抛出
+    std::string bad = input.substr(0, 1000) + "!" + input.substr(1000, 1000);
+    laxer::token_pipeline failing(l.make_cursor(bad), 16, 2);
+    std::size_t count = 0;
+    bool thrown       = false;
+    try {
+        while (not failing.next_token().is_eof()) {
+            count++;
+        }
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::string prefix = bad.substr(0, 1000);
+    l.reset(prefix);
+    assert(count == collect(l).size());
+
+    // 没有读完就销毁, 等待队列空位的生产者需要退出
+    {
+        laxer::token_pipeline unfinished(l.make_cursor(input), 4, 1);
+        unfinished.next_token();
+    }
+
+    std::cout << std::format("{} tokens\n", expected.size());
+    std::cout << "token pipeline test passed\n";
+
+    return 0;
+}
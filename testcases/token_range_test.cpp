@@ -0,0 +1,88 @@
+#include <cassert>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "laxer.hpp"
+#include "token.hpp"
+
+enum tokens
+{
+    number,
+    identifier,
+};
+
+void setup_rules(laxer::laxer& l)
+{
+    l.add_rule("\\d+", tokens::number, laxer::converter::dec, "numbers");
+    l.add_rule("[_a-zA-Z][_a-zA-Z0-9]*", tokens::identifier, {}, "identifiers");
+    l.add_rule("[ \r\n\t]+", 2, laxer::converter::ignore, "ignores");
+}
+
+int main(const int argc, const char** argv)
+{
+    std::string input;
+    for (int i = 0; i < 100; i++) {
+        input += std::format("name_{} {} ", i, i);
+    }
+
+    static_assert(std::ranges::input_range<laxer::laxer::token_range>);
+    static_assert(std::ranges::view<laxer::laxer::token_range>);
+
+    // 遍历全部token
+    laxer::laxer l(input);
+    setup_rules(l);
+
+    std::size_t count = 0;
+    for (const auto& token : l.tokens()) {
+        assert(token.get_token_id() == (count % 2 == 0 ? tokens::identifier : number));
+        count++;
+    }
+    assert(count == 200);
+
+    // 与std::views组合, 只匹配需要的部分
+    l.reset(input);
+
+    auto numbers = l.tokens() | std::views::filter([](const laxer::token& token) {
+                       return token.get_token_id() == tokens::number;
+                   })
+                 | std::views::transform([](const laxer::token& token) {
+                       return std::get<std::uint64_t>(token.get_token_value());
+                   })
+                 | std::views::take(5);
+
+    std::vector<std::uint64_t> values;
+    for (auto value : numbers) {
+        values.push_back(value);
+    }
+    assert((values == std::vector<std::uint64_t> {0, 1, 2, 3, 4}));
+
+    // take在取到第5个数字后停止, 剩余输入没有被匹配
+    assert(l.get_offset() < input.size() / 10);
+
+    // 流输入模式下逐个消费
+    std::stringbuf buffer(input);
+    laxer::laxer streamed(&buffer, 16);
+    setup_rules(streamed);
+
+    count = 0;
+    for (const auto& token : streamed.tokens()
+                                 | std::views::drop_while([](const laxer::token& token) {
+                                       return token.get_matched_text() != "name_50";
+                                   })) {
+        if (count == 0) {
+            assert(token.get_matched_text() == "name_50");
+        }
+        count++;
+    }
+    assert(count == 100);
+
+    std::cout << "token range test passed\n";
+
+    return 0;
+}
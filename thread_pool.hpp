@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace laxer {
+
+    // 工作窃取线程池
+    // 每个工作线程拥有自己的任务队列, 按提交顺序从自己的队首取任务, 队列为空时从其他线程的队尾窃取
+    class thread_pool {
+       public:
+        using task_t = std::function<void(void)>;
+
+       private:
+        struct queue_t
+        {
+            std::mutex lock;
+            std::deque<task_t> tasks;
+        };
+
+        std::vector<std::unique_ptr<queue_t>> queues;
+        // 提交任务时轮流选择的队列
+        std::atomic<std::size_t> next_queue;
+        // 已入队但还没有被取出的任务数
+        std::atomic<std::size_t> queued;
+        // 已提交但还没有执行完的任务数
+        std::atomic<std::size_t> pending;
+
+        std::mutex state_lock;
+        std::condition_variable has_task;
+        std::condition_variable all_done;
+        bool stopping;
+        // 任务抛出的第一个异常, 在wait中重新抛出
+        std::exception_ptr error;
+
+        // 必须最后声明, 析构时先汇合所有工作线程
+        std::vector<std::jthread> workers;
+
+        bool take(std::size_t index, task_t& task)
+        {
+            // 按提交顺序从自己的队首取任务
+            {
+                auto& own = *this->queues[index];
+                std::lock_guard guard(own.lock);
+
+                if (not own.tasks.empty()) {
+                    task = std::move(own.tasks.front());
+                    own.tasks.pop_front();
+                    this->queued--;
+                    return true;
+                }
+            }
+
+            // 从其他线程的队尾窃取, 与队列的所有者从两端取任务
+            for (std::size_t i = 1; i < this->queues.size(); i++) {
+                auto& other = *this->queues[(index + i) % this->queues.size()];
+                std::lock_guard guard(other.lock);
+
+                if (not other.tasks.empty()) {
+                    task = std::move(other.tasks.back());
+                    other.tasks.pop_back();
+                    this->queued--;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void work(std::size_t index)
+        {
+            task_t task;
+
+            while (true) {
+                if (not this->take(index, task)) {
+                    std::unique_lock guard(this->state_lock);
+
+                    this->has_task.wait(guard, [this] {
+                        return this->queued != 0 or this->stopping;
+                    });
+
+                    if (this->stopping and this->queued == 0) {
+                        return;
+                    }
+
+                    continue;
+                }
+
+                try {
+                    task();
+                } catch (...) {
+                    std::lock_guard guard(this->state_lock);
+                    if (not this->error) {
+                        this->error = std::current_exception();
+                    }
+                }
+
+                task = nullptr;
+
+                if (this->pending.fetch_sub(1) == 1) {
+                    std::lock_guard guard(this->state_lock);
+                    this->all_done.notify_all();
+                }
+            }
+        }
+
+       public:
+        // thread_count为0时使用硬件线程数
+        explicit thread_pool(std::size_t thread_count = 0)
+            : queues {},
+              next_queue(0),
+              queued(0),
+              pending(0),
+              stopping(false),
+              error {},
+              workers {}
+        {
+            if (thread_count == 0) {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            for (std::size_t i = 0; i < thread_count; i++) {
+                this->queues.push_back(std::make_unique<queue_t>());
+            }
+
+            for (std::size_t i = 0; i < thread_count; i++) {
+                this->workers.emplace_back([this, i] { this->work(i); });
+            }
+        }
+
+        thread_pool(const thread_pool&)            = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        // 执行完所有已提交的任务后退出
+        ~thread_pool()
+        {
+            {
+                std::lock_guard guard(this->state_lock);
+                this->stopping = true;
+            }
+
+            this->has_task.notify_all();
+        }
+
+        inline std::size_t size(void) const noexcept
+        {
+            return this->workers.size();
+        }
+
+        void submit(task_t task)
+        {
+            this->pending++;
+
+            // 先计数再入队, 任务被取出时计数已经包含它, 不会减到0以下
+            {
+                std::lock_guard guard(this->state_lock);
+                this->queued++;
+            }
+
+            {
+                auto& queue = *this->queues[this->next_queue++ % this->queues.size()];
+                std::lock_guard guard(queue.lock);
+                queue.tasks.push_back(std::move(task));
+            }
+
+            this->has_task.notify_one();
+        }
+
+        // 等待所有已提交的任务执行完, 任务抛出过异常时重新抛出第一个异常
+        void wait(void)
+        {
+            std::unique_lock guard(this->state_lock);
+
+            this->all_done.wait(guard, [this] { return this->pending == 0; });
+
+            if (this->error) {
+                std::rethrow_exception(std::exchange(this->error, nullptr));
+            }
+        }
+    };
+
+} // namespace laxer
@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <format>
 #include <functional>
+#include <limits>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <utility>
 #include <variant>
-#include "regex/nfa.hpp"
+#include "number_parser.hpp"
 #include "regex_typedef.hpp"
+#include "symbol_table.hpp"
 
+// 转换失败时仍然保留token, 值为空
 #define STATIC_CONVERT(fn)                \
     static bool fn(token &token) noexcept \
     {                                     \
@@ -19,39 +25,70 @@
 
 namespace laxer {
 
-    class token: public regex::final_state_t {
+    // 一次匹配产生的token记录, 只保存规则id, 匹配文本的位置和值, 可以按字节拷贝
+    // 规则名, 回调等元数据保存在laxer的规则表中, 通过规则id索引
+    class token {
        public:
         using id_t     = regex::id_t;
         using action_t = std::function<bool(token &)>;
 
+        // 符号表中的符号id, 文本通过符号表查询
+        struct symbol_t
+        {
+            id_t id;
+
+            bool operator==(const symbol_t &) const = default;
+        };
+
+        // 字符串值同样是输入缓冲区的视图, 与匹配文本的有效期相同;
+        // token_columns和incremental_lexer记录的字符串值由它们自己保证有效
+        using value_t = std::variant<std::monostate, std::uint64_t, double,
+                                     std::string_view, symbol_t>;
+
+        inline static constexpr id_t invalid_id = std::numeric_limits<id_t>::max();
+        // 保留的规则id: 输入结束, 以及没有任何规则能匹配的字节
+        inline static constexpr id_t eof_rule     = invalid_id;
+        inline static constexpr id_t default_rule = invalid_id - 1;
+
+        // 词法分析开始时所处的模式, 以及表示匹配后保持当前模式的模式id
+        inline static constexpr id_t initial_mode = 0;
+        inline static constexpr id_t keep_mode    = invalid_id;
+
        private:
+        id_t rule_id;
         id_t token_id;
-        std::string matched_text, rule_name;
-
-        action_t action;
-        std::variant<std::monostate, std::uint64_t, double, std::string> token_value;
+        // 匹配完成后切换到的模式
+        id_t next_mode;
+        // 匹配文本是输入缓冲区的视图, offset为其在输入中的字节偏移
+        std::string_view matched_text;
+        std::size_t offset;
+        value_t token_value;
 
        public:
-        // 实现终态类所必须的方法
-        token(id_t state_id = 0, id_t token_id = 0, const action_t &cb = {},
-              const std::string name = {})
-            : regex::final_state_t(state_id),
+        constexpr token(id_t rule_id = eof_rule, id_t token_id = invalid_id,
+                        std::string_view text = {}, std::size_t offset = 0) noexcept
+            : rule_id(rule_id),
               token_id(token_id),
-              matched_text {},
-              rule_name(std::move(name)),
-              action(cb)
+              next_mode(keep_mode),
+              matched_text(text),
+              offset(offset),
+              token_value {}
+        {
+        }
+
+        id_t get_rule_id(void) const noexcept
         {
+            return this->rule_id;
         }
 
-        // 实现其他方法
-        void add_matched_text(const std::string &text)
+        bool is_eof(void) const noexcept
         {
-            this->matched_text.append(text);
+            return this->rule_id == eof_rule;
         }
 
-        void add_matched_text(char text)
+        bool is_default(void) const noexcept
         {
-            this->matched_text.push_back(text);
+            return this->rule_id == default_rule;
         }
 
         void set_token_id(id_t id) noexcept
@@ -64,44 +101,36 @@ namespace laxer {
             return this->token_id;
         }
 
-        void set_matched_text(const std::string &text) noexcept
-        {
-            this->matched_text = text;
-        }
-
-        void set_matched_text(std::string &&text) noexcept
-        {
-            this->matched_text = std::move(text);
-        }
-
-        const auto &get_matched_text(void) const noexcept
+        // 回调可以通过修改它来切换模式, 默认值由规则决定
+        void set_next_mode(id_t mode) noexcept
         {
-            return this->matched_text;
+            this->next_mode = mode;
         }
 
-        void set_rule_name(const std::string &name) noexcept
+        id_t get_next_mode(void) const noexcept
         {
-            this->rule_name = name;
+            return this->next_mode;
         }
 
-        void set_rule_name(std::string &&name) noexcept
+        void set_matched_text(std::string_view text, std::size_t offset = 0) noexcept
         {
-            this->rule_name = std::move(name);
+            this->matched_text = text;
+            this->offset       = offset;
         }
 
-        const auto &get_rule_name(void) const noexcept
+        const auto &get_matched_text(void) const noexcept
         {
-            return this->rule_name;
+            return this->matched_text;
         }
 
-        void set_action(const action_t &action) noexcept
+        std::size_t get_offset(void) const noexcept
         {
-            this->action = action;
+            return this->offset;
         }
 
-        const auto &get_action(void) const noexcept
+        std::size_t get_length(void) const noexcept
         {
-            return this->action;
+            return this->matched_text.size();
         }
 
         template<typename T>
@@ -116,63 +145,90 @@ namespace laxer {
         }
 
         // token value converters
+        // 转换失败(溢出或非法字符)时值为空并返回错误码, 不分配内存也不抛出异常
 
-        // accept format 0b[01]+
-        void convert_bin(void) noexcept
+        // 按format解析text, 成功时写入value
+        static std::errc parse_number(std::string_view text,
+                                      number_parser::format_t format,
+                                      value_t &value) noexcept
         {
-            std::string_view matched_str(this->matched_text);
-            matched_str.remove_prefix(2);
-
-            std::uint32_t value = 0;
+            std::uint64_t integer = 0;
+            std::errc ec {};
+
+            switch (format) {
+                case number_parser::format_t::dec:
+                    ec = number_parser::parse_dec(text, integer);
+                    break;
+                case number_parser::format_t::hex:
+                    ec = number_parser::parse_hex(text, integer);
+                    break;
+                case number_parser::format_t::bin:
+                    ec = number_parser::parse_bin(text, integer);
+                    break;
+                case number_parser::format_t::fp64: {
+                    double real = 0;
+                    ec          = number_parser::parse_fp64(text, real);
+                    if (ec == std::errc {}) {
+                        value = real;
+                    }
+                    return ec;
+                }
+            }
 
-            for (char ch : matched_str) {
-                value <<= 1;
-                value |= (ch == '1');
+            if (ec == std::errc {}) {
+                value = integer;
             }
 
-            this->token_value = value;
+            return ec;
         }
 
-        // accept format \d+
-        void convert_dec(void) noexcept
+        std::errc convert_number(number_parser::format_t format) noexcept
         {
-            this->token_value = static_cast<std::uint64_t>(std::stoull(this->matched_text));
+            this->token_value = std::monostate {};
+
+            return parse_number(this->matched_text, format, this->token_value);
         }
 
-        // accept format 0x[a-fA-F0-9]+
-        void convert_hex(void) noexcept
+        // accept format 0b[01]+
+        std::errc convert_bin(void) noexcept
         {
-            std::string_view matched_str(this->matched_text);
-            matched_str.remove_prefix(2);
-
-            std::uint64_t value = 0;
+            return this->convert_number(number_parser::format_t::bin);
+        }
 
-            for (char ch : matched_str) {
-                value <<= 4;
-                if (ch >= '0' && ch <= '9') {
-                    value |= (ch - '0');
-                } else if (ch >= 'a' && ch <= 'f') {
-                    value |= (ch - 'a' + 10);
-                } else if (ch >= 'A' && ch <= 'F') {
-                    value |= (ch - 'A' + 10);
-                }
-            }
+        // accept format \d+
+        std::errc convert_dec(void) noexcept
+        {
+            return this->convert_number(number_parser::format_t::dec);
+        }
 
-            this->token_value = value;
+        // accept format 0x[a-fA-F0-9]+
+        std::errc convert_hex(void) noexcept
+        {
+            return this->convert_number(number_parser::format_t::hex);
         }
 
         // accept format \d+\.\d+
-        void convert_fp64(void) noexcept
+        std::errc convert_fp64(void) noexcept
         {
-            this->token_value = std::stod(this->matched_text);
+            return this->convert_number(number_parser::format_t::fp64);
         }
 
         void record_string(void) noexcept
         {
             this->token_value = this->matched_text;
         }
+
+        // 匹配文本复制到符号表中, 值为符号id, 相同的文本得到相同的id
+        void intern_symbol(symbol_table &table)
+        {
+            this->token_value = symbol_t {table.intern(this->matched_text)};
+        }
     };
 
+    static_assert(std::is_trivially_copyable_v<token>);
+
+    // 数值转换回调总是保留token: 溢出或含非法字符时值为空(std::monostate),
+    // 需要区分失败的调用者检查值是否为空, 或直接调用token::convert_*获取错误码
     class converter {
        public:
         STATIC_CONVERT(bin);
@@ -187,6 +243,17 @@ namespace laxer {
             return true;
         }
 
+        // 标识符和关键字使用, 值不引用输入缓冲区, 流式输入的窗口移动后仍然有效
+        // 返回的回调引用table, table需要比使用它的laxer存活更久
+        static token::action_t intern(symbol_table &table)
+        {
+            return [&table](token &token) {
+                token.intern_symbol(table);
+
+                return true;
+            };
+        }
+
         static bool ignore(token &token) noexcept
         {
             return false;
@@ -211,10 +278,9 @@ namespace std {
             -> decltype(ctx.out())
         {
             return std::format_to(
-                ctx.out(),
-                "token(dfa_state_id={}, token_id={}, matched_text={}, rule_name={})",
-                static_cast<laxer::token::id_t>(tok), tok.get_token_id(),
-                tok.get_matched_text(), tok.get_rule_name());
+                ctx.out(), "token(rule_id={}, token_id={}, offset={}, matched_text={})",
+                tok.get_rule_id(), tok.get_token_id(), tok.get_offset(),
+                tok.get_matched_text());
         }
     };
 
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "lexer_cursor.hpp"
+#include "token.hpp"
+
+namespace laxer {
+
+    // 固定容量的token前瞻缓冲区, 用于LL(k)分析
+    // 已经匹配的token保存在环形缓冲区中, peek不会消耗token, rewind回到标记处时不需要重新匹配;
+    // 流输入模式下窗口会随补充数据移动, 因此把token文本拷贝到槽位自己的存储中, 存储在槽位间复用
+    class token_buffer {
+       public:
+        inline static constexpr std::size_t default_capacity = 16;
+
+       private:
+        struct slot_t
+        {
+            token tok;
+            // 流输入模式下token文本的拷贝
+            std::string text;
+        };
+
+        // 产生token的对象, 可以是laxer, lexer_cursor或token_pipeline
+        void* source;
+        token (*next)(void*);
+        bool (*streaming)(const void*);
+        std::vector<slot_t> slots;
+        std::size_t mask;
+        // 以下均为从输入开头开始计数的token序号
+        // 下一个要消耗的token
+        std::size_t read;
+        // 已经匹配的token的下一个
+        std::size_t tail;
+        // 尚未释放的标记, 标记之后的token不能被覆盖
+        std::vector<std::size_t> marks;
+
+        // 最早仍然需要保留的token
+        inline std::size_t get_oldest(void) const noexcept
+        {
+            return this->marks.empty() ? this->read : this->marks.front();
+        }
+
+        // 匹配下一个token放入缓冲区
+        void fill(void)
+        {
+            if (this->tail - this->get_oldest() == this->slots.size()) {
+                throw lexer_cursor::laxer_error(
+                    "token lookahead exceeds the buffer capacity");
+            }
+
+            auto& slot = this->slots[this->tail & this->mask];
+            slot.tok   = this->next(this->source);
+
+            if (this->streaming(this->source)) {
+                this->own_text(slot);
+            }
+
+            this->tail++;
+        }
+
+        // rewind和release都需要一个尚未释放的标记
+        void check_marked(void) const
+        {
+            if (this->marks.empty()) {
+                throw lexer_cursor::laxer_error("token buffer has no mark to return to");
+            }
+        }
+
+        // 把token文本以及引用文本的字符串值改为指向槽位自己的存储
+        static void own_text(slot_t& slot)
+        {
+            auto text = slot.tok.get_matched_text();
+            slot.text.assign(text);
+            slot.tok.set_matched_text(slot.text, slot.tok.get_offset());
+
+            if (auto value = std::get_if<std::string_view>(&slot.tok.get_token_value())) {
+                if (value->data() >= text.data()
+                    and value->data() + value->size() <= text.data() + text.size()) {
+                    slot.tok.set_token_value(std::string_view(slot.text).substr(
+                        value->data() - text.data(), value->size()));
+                }
+            }
+        }
+
+       public:
+        // 容量向上取整为2的幂, 同时决定最大前瞻距离和标记之后最多能保留的token数
+        // source需要提供next_token和is_streaming, 并且在token_buffer的生命周期内有效
+        template <typename source_t>
+        explicit token_buffer(source_t& source, std::size_t capacity = default_capacity)
+            : source(&source),
+              next([](void* source) {
+                  return static_cast<source_t*>(source)->next_token();
+              }),
+              streaming([](const void* source) {
+                  return static_cast<const source_t*>(source)->is_streaming();
+              }),
+              slots(std::bit_ceil(std::max<std::size_t>(capacity, 1))),
+              mask(slots.size() - 1),
+              read(0),
+              tail(0),
+              marks {}
+        {
+        }
+
+        token_buffer(const token_buffer&)            = delete;
+        token_buffer& operator=(const token_buffer&) = delete;
+
+        // 查看之后第k个token而不消耗, k为0时为下一个token; 输入结束后一直返回EOF
+        // 返回的引用在该token被消耗并且槽位被复用前有效
+        const token& peek(std::size_t k = 0)
+        {
+            while (this->tail <= this->read + k) {
+                this->fill();
+            }
+
+            return this->slots[(this->read + k) & this->mask].tok;
+        }
+
+        // 消耗并返回下一个token
+        token consume(void)
+        {
+            token result = this->peek();
+            this->read++;
+
+            return result;
+        }
+
+        // 在当前位置设置标记, 之后可以rewind回到这里; 标记可以嵌套
+        void mark(void)
+        {
+            this->marks.push_back(this->read);
+        }
+
+        // 回到最近的标记处并释放该标记
+        void rewind(void)
+        {
+            this->check_marked();
+
+            this->read = this->marks.back();
+            this->marks.pop_back();
+        }
+
+        // 释放最近的标记, 保持当前位置
+        void release(void)
+        {
+            this->check_marked();
+
+            this->marks.pop_back();
+        }
+
+        inline std::size_t get_capacity(void) const noexcept
+        {
+            return this->slots.size();
+        }
+
+        // 已经匹配但还没有被消耗的token数
+        inline std::size_t get_buffered(void) const noexcept
+        {
+            return this->tail - this->read;
+        }
+    };
+
+} // namespace laxer
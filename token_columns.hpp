@@ -0,0 +1,368 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "number_parser.hpp"
+#include "rule.hpp"
+#include "token.hpp"
+
+namespace laxer {
+
+    // 以列存储的token流, 每个token只占用 (token id, 起始偏移, 长度) 三列,
+    // 可选的值列只在需要时填充, 便于后续阶段顺序遍历
+    class token_columns {
+       public:
+        using id_t    = token::id_t;
+        using value_t = token::value_t;
+
+        // 预留容量时使用的平均token长度
+        inline static constexpr std::size_t estimated_token_length = 4;
+        // 初始预留的token数上限, 超出部分由vector按几何级数增长,
+        // 避免大文件在匹配第一个token之前就提交数倍于文件大小的内存
+        inline static constexpr std::size_t max_initial_reserve = 1 << 20;
+
+        // 根据输入的字节数估计初始应预留的token数
+        static constexpr std::size_t estimated_capacity(std::size_t bytes) noexcept
+        {
+            return std::min(bytes / estimated_token_length, max_initial_reserve);
+        }
+
+       private:
+        std::vector<id_t> ids;
+        std::vector<std::size_t> offsets;
+        std::vector<std::uint32_t> lengths;
+        std::vector<value_t> values;
+        bool with_values;
+        // 从流输入拷贝出来的字符串值的存储, 在token_columns的副本之间共享
+        std::vector<std::shared_ptr<const std::string>> owned_texts;
+
+        // 长度列只有32位, 超过4GiB的token(映射的大文件中的错误段等)无法记录
+        static std::uint32_t narrow(std::size_t length)
+        {
+            if (length > std::numeric_limits<std::uint32_t>::max()) [[unlikely]] {
+                throw std::length_error(
+                    std::format("token of {} bytes exceeds the length column", length));
+            }
+
+            return static_cast<std::uint32_t>(length);
+        }
+
+       public:
+        explicit token_columns(bool with_values = false)
+            : ids {},
+              offsets {},
+              lengths {},
+              values {},
+              with_values(with_values),
+              owned_texts {}
+        {
+        }
+
+        void push_back(id_t id, std::size_t offset, std::size_t length)
+        {
+            auto narrowed = narrow(length);
+
+            this->ids.push_back(id);
+            this->offsets.push_back(offset);
+            this->lengths.push_back(narrowed);
+
+            if (this->with_values) {
+                this->values.emplace_back();
+            }
+        }
+
+        void push_back(id_t id, std::size_t offset, std::size_t length,
+                       const value_t& value)
+        {
+            auto narrowed = narrow(length);
+
+            this->ids.push_back(id);
+            this->offsets.push_back(offset);
+            this->lengths.push_back(narrowed);
+
+            if (this->with_values) {
+                this->values.push_back(value);
+            }
+        }
+
+        // 记录一次匹配, 规则带回调时先构造token并调用回调, 回调拒绝时不记录并返回false
+        // matched为nullptr表示没有规则能匹配的字节, 作为default token记录;
+        // 规则或回调要求切换模式时更新mode
+        bool push_match(const rule* matched, std::string_view text, std::size_t offset,
+                        id_t& mode)
+        {
+            if (matched == nullptr) {
+                this->push_back(token::invalid_id, offset, text.size());
+                return true;
+            }
+
+            // 跳过规则不记录也不调用回调
+            if (matched->is_skip()) {
+                if (matched->get_next_mode() != token::keep_mode) {
+                    mode = matched->get_next_mode();
+                }
+
+                return false;
+            }
+
+            const auto& action = matched->get_action();
+
+            if (not action) {
+                if (matched->get_next_mode() != token::keep_mode) {
+                    mode = matched->get_next_mode();
+                }
+
+                this->push_back(matched->get_token_id(), offset, text.size());
+                return true;
+            }
+
+            token cur_token = matched->make_token(text, offset);
+            bool kept       = action(cur_token);
+
+            if (cur_token.get_next_mode() != token::keep_mode) {
+                mode = cur_token.get_next_mode();
+            }
+
+            if (not kept) {
+                return false;
+            }
+
+            this->push_back(cur_token.get_token_id(), offset, text.size(),
+                            cur_token.get_token_value());
+            return true;
+        }
+
+        // 只有一个模式时使用
+        inline bool push_match(const rule* matched, std::string_view text,
+                               std::size_t offset)
+        {
+            id_t mode = token::initial_mode;
+
+            return this->push_match(matched, text, offset, mode);
+        }
+
+        // 追加另一组token列
+        void append(const token_columns& other)
+        {
+            this->ids.insert(this->ids.end(), other.ids.begin(), other.ids.end());
+            this->offsets.insert(this->offsets.end(), other.offsets.begin(),
+                                 other.offsets.end());
+            this->lengths.insert(this->lengths.end(), other.lengths.begin(),
+                                 other.lengths.end());
+
+            if (this->with_values) {
+                if (other.with_values) {
+                    this->values.insert(this->values.end(), other.values.begin(),
+                                        other.values.end());
+                    this->owned_texts.insert(this->owned_texts.end(),
+                                             other.owned_texts.begin(),
+                                             other.owned_texts.end());
+                } else {
+                    this->values.resize(this->ids.size());
+                }
+            }
+        }
+
+        // 用replacement替换从first开始的count个token
+        void replace(std::size_t first, std::size_t count,
+                     const token_columns& replacement)
+        {
+            auto splice = [first, count](auto& column, const auto& other) {
+                auto begin = column.begin() + first;
+                column.insert(column.erase(begin, begin + count), other.begin(),
+                              other.end());
+            };
+
+            splice(this->ids, replacement.ids);
+            splice(this->offsets, replacement.offsets);
+            splice(this->lengths, replacement.lengths);
+
+            if (this->with_values) {
+                if (replacement.with_values) {
+                    splice(this->values, replacement.values);
+                    this->owned_texts.insert(this->owned_texts.end(),
+                                             replacement.owned_texts.begin(),
+                                             replacement.owned_texts.end());
+                } else {
+                    splice(this->values, std::vector<value_t>(replacement.size()));
+                }
+            }
+        }
+
+        // 把从first开始的token的偏移整体移动delta
+        void shift(std::size_t first, std::ptrdiff_t delta) noexcept
+        {
+            for (std::size_t i = first; i < this->offsets.size(); i++) {
+                this->offsets[i] += delta;
+            }
+        }
+
+        // 把第index个token的字符串值拷贝到自己的存储中
+        // 流输入的窗口补充数据后会移动, 记录的字符串值需要在此之前拷贝
+        void own_value(std::size_t index)
+        {
+            auto value = std::get_if<std::string_view>(&this->values[index]);
+            if (value == nullptr) {
+                return;
+            }
+
+            auto text = std::make_shared<const std::string>(*value);
+            *value    = *text;
+            this->owned_texts.push_back(std::move(text));
+        }
+
+        // 文本被替换为new_text后, 把指向旧文本old_text的字符串值改为指向new_text中相同的字节,
+        // 从first开始的token在新文本中移动了delta; 只比较地址, old_text可以已经被释放
+        void rebase_values(std::string_view old_text, std::string_view new_text,
+                           std::size_t first, std::ptrdiff_t delta) noexcept
+        {
+            auto old_begin = reinterpret_cast<std::uintptr_t>(old_text.data());
+
+            for (std::size_t i = 0; i < this->values.size(); i++) {
+                auto value = std::get_if<std::string_view>(&this->values[i]);
+                if (value == nullptr) {
+                    continue;
+                }
+
+                auto inside = [value](std::size_t position, std::string_view text) {
+                    return position <= text.size()
+                       and value->size() <= text.size() - position;
+                };
+
+                auto address  = reinterpret_cast<std::uintptr_t>(value->data());
+                auto position = static_cast<std::size_t>(address - old_begin);
+                if (not inside(position, old_text)) {
+                    continue;
+                }
+
+                if (i >= first) {
+                    position += delta;
+                }
+
+                if (inside(position, new_text)) {
+                    *value = new_text.substr(position, value->size());
+                }
+            }
+        }
+
+        void reserve(std::size_t count)
+        {
+            this->ids.reserve(count);
+            this->offsets.reserve(count);
+            this->lengths.reserve(count);
+
+            if (this->with_values) {
+                this->values.reserve(count);
+            }
+        }
+
+        void clear(void) noexcept
+        {
+            this->ids.clear();
+            this->offsets.clear();
+            this->lengths.clear();
+            this->values.clear();
+            this->owned_texts.clear();
+        }
+
+        inline std::size_t size(void) const noexcept
+        {
+            return this->ids.size();
+        }
+
+        inline bool empty(void) const noexcept
+        {
+            return this->ids.empty();
+        }
+
+        inline bool has_values(void) const noexcept
+        {
+            return this->with_values;
+        }
+
+        inline std::span<const id_t> get_ids(void) const noexcept
+        {
+            return this->ids;
+        }
+
+        inline std::span<const std::size_t> get_offsets(void) const noexcept
+        {
+            return this->offsets;
+        }
+
+        inline std::span<const std::uint32_t> get_lengths(void) const noexcept
+        {
+            return this->lengths;
+        }
+
+        // 未启用值列时为空
+        inline std::span<const value_t> get_values(void) const noexcept
+        {
+            return this->values;
+        }
+
+        // 批量转换数值: 把token id为id的token的文本按format解析后写入值列,
+        // 不构造token也不调用回调, 规则不带转换回调时可以在分析结束后一次完成
+        // 返回转换失败的token数, 失败的token值为空; 未启用值列时不做任何事
+        // input应为生成这些列的输入, 超出input范围的token同样计为失败
+        std::size_t convert_numbers(std::string_view input, id_t id,
+                                    number_parser::format_t format) noexcept
+        {
+            if (not this->with_values) {
+                return 0;
+            }
+
+            std::size_t failed = 0;
+            for (std::size_t i = 0; i < this->ids.size(); i++) {
+                if (this->ids[i] != id) {
+                    continue;
+                }
+
+                auto& value = this->values[i];
+                value       = std::monostate {};
+
+                if (not this->in_range(i, input)) [[unlikely]] {
+                    failed++;
+                    continue;
+                }
+
+                auto text = input.substr(this->offsets[i], this->lengths[i]);
+                failed   += token::parse_number(text, format, value) != std::errc {};
+            }
+
+            return failed;
+        }
+
+        // 第index个token是否位于input之内, input比生成这些列的输入短时可能不在
+        inline bool in_range(std::size_t index, std::string_view input) const noexcept
+        {
+            return this->offsets[index] <= input.size()
+               and this->lengths[index] <= input.size() - this->offsets[index];
+        }
+
+        // 从原始输入中取出第index个token的文本, 超出input范围时返回空文本
+        inline std::string_view get_text(std::size_t index,
+                                         std::string_view input) const noexcept
+        {
+            if (not this->in_range(index, input)) [[unlikely]] {
+                return {};
+            }
+
+            return input.substr(this->offsets[index], this->lengths[index]);
+        }
+    };
+
+} // namespace laxer
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "lexer_cursor.hpp"
+#include "token.hpp"
+
+namespace laxer {
+
+    class laxer;
+
+    // 流水线式词法分析: 专门的线程匹配token并按批写入单生产者单消费者的环形队列,
+    // 分析器线程通过同样的next_token接口取出, 使词法分析与语法分析在两个核上同时进行
+    // 队列满时生产者等待消费者释放批次, 内存占用不超过batch_count个批次
+    class token_pipeline {
+       public:
+        inline static constexpr std::size_t default_batch_size  = 512;
+        inline static constexpr std::size_t default_batch_count = 4;
+
+       private:
+        struct batch_t
+        {
+            std::vector<token> tokens;
+            // 流输入模式下本批token文本的拷贝
+            std::string text;
+            // 生产者抛出的异常, 在消费者读完本批token后重新抛出
+            std::exception_ptr error;
+        };
+
+        lexer_cursor cursor;
+        std::size_t batch_size;
+        std::vector<batch_t> batches;
+
+        // 生产者和消费者各自写入的计数放在不同的缓存行, 避免伪共享
+        // 已经写完的批次数, 由生产者写入
+        alignas(64) std::atomic<std::size_t> tail;
+        // 已经释放的批次数, 由消费者写入
+        alignas(64) std::atomic<std::size_t> head;
+        std::atomic<bool> stopping;
+
+        // 以下只由消费者访问
+        // 正在读取的批次序号以及下一个token在批次中的位置
+        std::size_t reading;
+        std::size_t position;
+        bool has_batch;
+
+        // 必须最后声明, 析构时先汇合生产者线程
+        std::jthread producer;
+
+        // 把本批token文本拷贝到批次自己的存储中, 引用文本的字符串值同样改为指向拷贝
+        static void own_text(batch_t& batch, std::vector<std::size_t>& value_offsets)
+        {
+            std::size_t text_offset = 0;
+            std::string_view text(batch.text);
+
+            for (std::size_t i = 0; i < batch.tokens.size(); i++) {
+                auto& tok   = batch.tokens[i];
+                auto length = tok.get_length();
+
+                tok.set_matched_text(text.substr(text_offset, length), tok.get_offset());
+
+                if (value_offsets[i] != std::string_view::npos) {
+                    auto value = std::get<std::string_view>(tok.get_token_value());
+                    tok.set_token_value(
+                        text.substr(text_offset + value_offsets[i], value.size()));
+                }
+
+                text_offset += length;
+            }
+        }
+
+        // 匹配一批token, 输入结束或出错时返回false
+        bool fill(batch_t& batch, std::vector<std::size_t>& value_offsets)
+        {
+            bool streaming = this->cursor.is_streaming();
+            bool more      = true;
+
+            batch.tokens.clear();
+            batch.text.clear();
+            batch.error = nullptr;
+            value_offsets.clear();
+
+            try {
+                while (batch.tokens.size() < this->batch_size) {
+                    const auto& tok =
+                        batch.tokens.emplace_back(this->cursor.next_token());
+
+                    // 流输入的窗口在下一次匹配时可能移动, 先记下文本和值的相对位置
+                    if (streaming) {
+                        auto text = tok.get_matched_text();
+                        auto rel  = std::string_view::npos;
+
+                        if (auto value = std::get_if<std::string_view>(
+                                &tok.get_token_value());
+                            value and value->data() >= text.data()
+                            and value->data() + value->size()
+                                    <= text.data() + text.size()) {
+                            rel = static_cast<std::size_t>(value->data() - text.data());
+                        }
+
+                        batch.text.append(text);
+                        value_offsets.push_back(rel);
+                    }
+
+                    if (tok.is_eof()) {
+                        more = false;
+                        break;
+                    }
+                }
+            } catch (...) {
+                batch.error = std::current_exception();
+                more        = false;
+            }
+
+            if (streaming) {
+                own_text(batch, value_offsets);
+            }
+
+            return more;
+        }
+
+        void produce(void)
+        {
+            std::vector<std::size_t> value_offsets;
+            bool more = true;
+
+            for (std::size_t filled = 0; more; filled++) {
+                // 队列已满, 等待消费者释放批次
+                auto head = this->head.load(std::memory_order_acquire);
+                while (filled - head == this->batches.size()
+                       and not this->stopping.load(std::memory_order_relaxed)) {
+                    this->head.wait(head, std::memory_order_acquire);
+                    head = this->head.load(std::memory_order_acquire);
+                }
+
+                if (this->stopping.load(std::memory_order_relaxed)) {
+                    return;
+                }
+
+                more = this->fill(this->batches[filled % this->batches.size()],
+                                  value_offsets);
+
+                this->tail.store(filled + 1, std::memory_order_release);
+                this->tail.notify_one();
+            }
+        }
+
+        // 释放当前批次并等待下一批
+        void next_batch(void)
+        {
+            if (this->has_batch) {
+                this->reading++;
+                this->head.store(this->reading, std::memory_order_release);
+                this->head.notify_one();
+            }
+
+            auto tail = this->tail.load(std::memory_order_acquire);
+            while (tail == this->reading) {
+                this->tail.wait(tail, std::memory_order_acquire);
+                tail = this->tail.load(std::memory_order_acquire);
+            }
+
+            this->position  = 0;
+            this->has_batch = true;
+        }
+
+       public:
+        // 接管cursor并立即在新线程上开始匹配, cursor剩余的输入全部由流水线消耗,
+        // 由laxer::make_cursor或共享的compiled_lexer构造
+        // 规则回调在生产者线程上调用, 抛出的异常在消费者读到对应位置时重新抛出
+        explicit token_pipeline(lexer_cursor cursor,
+                                std::size_t batch_size  = default_batch_size,
+                                std::size_t batch_count = default_batch_count)
+            : cursor(std::move(cursor)),
+              batch_size(std::max<std::size_t>(batch_size, 1)),
+              batches(std::max<std::size_t>(batch_count, 1)),
+              tail(0),
+              head(0),
+              stopping(false),
+              reading(0),
+              position(0),
+              has_batch(false),
+              producer {}
+        {
+            for (auto& batch : this->batches) {
+                batch.tokens.reserve(this->batch_size);
+            }
+
+            this->producer = std::jthread([this] {
+                this->produce();
+            });
+        }
+
+        // laxer会被切割为lexer_cursor, 还没有编译时在生产者线程上才报错, 应改用make_cursor
+        token_pipeline(laxer&&, std::size_t = 0, std::size_t = 0) = delete;
+
+        token_pipeline(const token_pipeline&)            = delete;
+        token_pipeline& operator=(const token_pipeline&) = delete;
+
+        ~token_pipeline(void)
+        {
+            // 唤醒可能正在等待队列空位的生产者
+            this->stopping.store(true, std::memory_order_relaxed);
+            this->head.fetch_add(1, std::memory_order_release);
+            this->head.notify_one();
+        }
+
+        // 与lexer_cursor::next_token相同, 输入结束后一直返回EOF
+        // 流输入模式下token文本在下一次调用next_token前有效
+        token next_token(void)
+        {
+            if (not this->has_batch) {
+                this->next_batch();
+            }
+
+            while (true) {
+                const auto& batch = this->batches[this->reading % this->batches.size()];
+
+                if (this->position < batch.tokens.size()) {
+                    const auto& tok = batch.tokens[this->position];
+
+                    // EOF不前移, 之后的调用继续返回它
+                    if (not tok.is_eof()) {
+                        this->position++;
+                    }
+
+                    return tok;
+                }
+
+                if (batch.error) {
+                    std::rethrow_exception(batch.error);
+                }
+
+                this->next_batch();
+            }
+        }
+
+        inline bool is_streaming(void) const noexcept
+        {
+            return this->cursor.is_streaming();
+        }
+
+        inline std::size_t get_batch_size(void) const noexcept
+        {
+            return this->batch_size;
+        }
+
+        inline std::size_t get_batch_count(void) const noexcept
+        {
+            return this->batches.size();
+        }
+    };
+
+} // namespace laxer
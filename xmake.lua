@@ -23,6 +23,10 @@ target('laxer-engine')
     add_includedirs('.', {public=true})
     add_deps('regex-engine')
 
+    if not is_plat('windows', 'mingw') then
+        add_syslinks('pthread', {public=true})
+    end
+
 target('laxer')
     set_kind('binary')
     add_deps('laxer-engine')